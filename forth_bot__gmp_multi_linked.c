@@ -27,7 +27,7 @@
 
 // Après les #define et les includes
 typedef enum {
-    OP_PUSH, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_DUP, OP_SWAP, OP_OVER,
+    OP_PUSH, OP_PUSH_BIG, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_DUP, OP_SWAP, OP_OVER,
     OP_ROT, OP_DROP, OP_EQ, OP_LT, OP_GT, OP_AND, OP_OR, OP_NOT, OP_XOR, OP_I, OP_J,
     OP_DO, OP_LOOP, OP_BRANCH_FALSE, OP_BRANCH,
     OP_UNLOOP, OP_PLUS_LOOP, OP_SQRT, OP_CALL, OP_END, OP_DOT_QUOTE, OP_LITSTRING,
@@ -53,6 +53,8 @@ typedef struct {
     long int code_length;
     char *strings[WORD_CODE_SIZE];
     long int string_count;
+    mpz_t *constants;      // Littéraux trop grands pour un long, parsés une fois à la compilation
+    long int constant_count;
     int immediate;
 } CompiledWord;
 
@@ -165,6 +167,8 @@ void initDynamicDictionary(DynamicDictionary *dict) {
         dict->words[i].name = NULL;
         dict->words[i].code_length = 0;
         dict->words[i].string_count = 0;
+        dict->words[i].constants = NULL;
+        dict->words[i].constant_count = 0;
         dict->words[i].immediate = 0;
     }
 }
@@ -181,6 +185,8 @@ void resizeDynamicDictionary(DynamicDictionary *dict) {
         dict->words[i].name = NULL;
         dict->words[i].code_length = 0;
         dict->words[i].string_count = 0;
+        dict->words[i].constants = NULL;
+        dict->words[i].constant_count = 0;
         dict->words[i].immediate = 0;
     }
     dict->capacity = new_capacity;
@@ -198,6 +204,22 @@ void addWord(DynamicDictionary *dict, const char *name, OpCode opcode, int immed
     word->immediate = immediate;
     dict->count++;
 }
+
+void freeWordConstants(CompiledWord *word) {
+    for (long int i = 0; i < word->constant_count; i++) mpz_clear(word->constants[i]);
+    free(word->constants);
+    word->constants = NULL;
+    word->constant_count = 0;
+}
+
+// Ajoute un grand littéral au pool du mot et renvoie son index
+long int addWordConstant(CompiledWord *word, mpz_t value) {
+    mpz_t *new_constants = realloc(word->constants, (word->constant_count + 1) * sizeof(mpz_t));
+    if (!new_constants) return -1;
+    word->constants = new_constants;
+    mpz_init_set(word->constants[word->constant_count], value);
+    return word->constant_count++;
+}
  
 void send_to_channel(const char *msg) {
     if (irc_socket != -1) {
@@ -272,6 +294,8 @@ void initEnv(Env *env, const char *nick) {
     env->currentWord.name = NULL;
     env->currentWord.code_length = 0;
     env->currentWord.string_count = 0;
+    env->currentWord.constants = NULL;
+    env->currentWord.constant_count = 0;
     env->compiling = 0;
     env->current_word_index = -1;
 
@@ -322,20 +346,17 @@ void freeEnv(const char *nick) {
         for (int j = 0; j < curr->dictionary.words[i].string_count; j++) {
             if (curr->dictionary.words[i].strings[j]) free(curr->dictionary.words[i].strings[j]);
         }
+        freeWordConstants(&curr->dictionary.words[i]);
     }
     free(curr->dictionary.words); // Libérer le tableau dynamique
 
-    MemoryNode *node = curr->memory_list.head;
-    while (node) {
-        MemoryNode *next = node->next;
-        memory_free(&curr->memory_list, node->name);
-        node = next;
-    }
+    memory_destroy(&curr->memory_list);
 
     if (curr->currentWord.name) free(curr->currentWord.name);
     for (int i = 0; i < curr->currentWord.string_count; i++) {
         if (curr->currentWord.strings[i]) free(curr->currentWord.strings[i]);
     }
+    freeWordConstants(&curr->currentWord);
     for (int i = 0; i <= curr->string_stack_top; i++) {
         if (curr->string_stack[i]) free(curr->string_stack[i]);
     }
@@ -434,10 +455,19 @@ void print_word_definition_irc(int index, Stack *stack) {
 
         switch (instr.opcode) {
             case OP_PUSH:
-                if (instr.operand < word->string_count && word->strings[instr.operand]) {
-                    snprintf(instr_str, sizeof(instr_str), "%s ", word->strings[instr.operand]);
+                snprintf(instr_str, sizeof(instr_str), "%ld ", instr.operand);
+                break;
+            case OP_PUSH_BIG:
+                if (instr.operand >= 0 && instr.operand < word->constant_count) {
+                    char *num_str = mpz_get_str(NULL, 10, word->constants[instr.operand]);
+                    if (strlen(num_str) < sizeof(instr_str) - 1) {
+                        snprintf(instr_str, sizeof(instr_str), "%s ", num_str);
+                    } else {
+                        snprintf(instr_str, sizeof(instr_str), "(%zu digits) ", strlen(num_str));
+                    }
+                    free(num_str);
                 } else {
-                    snprintf(instr_str, sizeof(instr_str), "%ld ", instr.operand);
+                    snprintf(instr_str, sizeof(instr_str), "(PUSH_BIG %ld) ", instr.operand);
                 }
                 break;
             case OP_CALL:
@@ -736,18 +766,15 @@ unsigned long encoded_idx;
     switch (instr.opcode) {
  
 case OP_PUSH:
-    if (instr.operand < word->string_count && word->strings[instr.operand]) {
-        if (mpz_set_str(*result, word->strings[instr.operand], 10) == 0) {
-            push(stack, *result);
-        } else {
-            set_error("OP_PUSH: Invalid string number");
-        }
+    mpz_set_si(*result, instr.operand);
+    push(stack, *result);
+    break;
+case OP_PUSH_BIG:
+    if (instr.operand >= 0 && instr.operand < word->constant_count) {
+        push(stack, word->constants[instr.operand]);
     } else {
-        mpz_set_ui(*result, instr.operand);
-        push(stack, *result);
+        set_error("OP_PUSH_BIG: Invalid constant index");
     }
-    break;
-    push(stack, *result);
     break;
         case OP_ADD:
             pop(stack, *b);
@@ -1031,7 +1058,7 @@ case OP_STORE:
             break;
         }
         pop(stack, *a);
-        memory_store(&currentenv->memory_list, encoded_idx, a);
+        cell_set_mpz(&node->value.number, *a);
         /*  snprintf(debug_msg, sizeof(debug_msg), "STORE: Set %s = %s", node->name, mpz_get_str(NULL, 10, *a));
         send_to_channel(debug_msg);
         */
@@ -1049,7 +1076,7 @@ case OP_STORE:
         send_to_channel(debug_msg);
         */
         if (offset >= 0 && offset < node->value.array.size) {
-            mpz_set(node->value.array.data[offset], *b);
+            cell_set_mpz(&node->value.array.data[offset], *b);
             /* snprintf(debug_msg, sizeof(debug_msg), "STORE: Set %s[%d] = %s", node->name, offset, mpz_get_str(NULL, 10, *b));
             send_to_channel(debug_msg);
             */ 
@@ -1117,7 +1144,7 @@ case OP_FETCH:
     send_to_channel(debug_msg);
 */
     if (type == TYPE_VAR) {
-        memory_fetch(&currentenv->memory_list, encoded_idx, result);
+        cell_get_mpz(*result, &node->value.number);
         /* snprintf(debug_msg, sizeof(debug_msg), "FETCH: Got variable %s = %s", node->name, mpz_get_str(NULL, 10, *result));
         send_to_channel(debug_msg);
         */
@@ -1134,7 +1161,7 @@ case OP_FETCH:
         send_to_channel(debug_msg);
         */
         if (offset >= 0 && offset < node->value.array.size) {
-            mpz_set(*result, node->value.array.data[offset]);
+            cell_get_mpz(*result, &node->value.array.data[offset]);
             /* snprintf(debug_msg, sizeof(debug_msg), "FETCH: Got %s[%d] = %s", node->name, offset, mpz_get_str(NULL, 10, *result));
             send_to_channel(debug_msg);
             */ 
@@ -1198,7 +1225,7 @@ case OP_FETCH:
                 push(stack, *a);
                 break;
             }
-            mpz_t *array = (mpz_t *)malloc(size * sizeof(mpz_t));
+            Cell *array = (Cell *)malloc(size * sizeof(Cell));
             if (!array) {
                 set_error("ALLOT: Memory allocation failed");
                 push(stack, *result);
@@ -1206,10 +1233,10 @@ case OP_FETCH:
                 break;
             }
             for (int i = 0; i < size; i++) {
-                mpz_init_set_ui(array[i], 0);
+                cell_init(&array[i]);
             }
             if (node->type == TYPE_VAR) {
-                mpz_clear(node->value.number);
+                cell_clear(&node->value.number);
             }
             node->type = TYPE_ARRAY;
             node->value.array.data = array;
@@ -1444,8 +1471,11 @@ case OP_FORGET:
                 if (dict_word->code_length == 1 && dict_word->code[0].opcode == OP_PUSH) {
                     unsigned long encoded_idx = dict_word->code[0].operand;
                     unsigned long type = memory_get_type(encoded_idx);
-                    if (type == TYPE_VAR || type == TYPE_STRING || type == TYPE_ARRAY) {
-                        memory_free(&currentenv->memory_list, dict_word->name);
+                    MemoryNode *mem = memory_get(&currentenv->memory_list, encoded_idx);
+                    // Libération directe par handle, seulement s’il désigne bien ce mot
+                    if ((type == TYPE_VAR || type == TYPE_STRING || type == TYPE_ARRAY) &&
+                        mem && dict_word->name && strcmp(mem->name, dict_word->name) == 0) {
+                        memory_free_handle(&currentenv->memory_list, encoded_idx);
                     }
                 }
                 if (dict_word->name) {
@@ -1458,6 +1488,7 @@ case OP_FORGET:
                         dict_word->strings[j] = NULL;
                     }
                 }
+                freeWordConstants(dict_word);
                 dict_word->code_length = 0;
                 dict_word->string_count = 0;
             }
@@ -1575,7 +1606,9 @@ case OP_PLUSSTORE:
 
     if (node->type == TYPE_VAR) {
         // Cas variable : *b est la valeur à ajouter
-        mpz_add(node->value.number, node->value.number, *b);
+        cell_get_mpz(*result, &node->value.number);
+        mpz_add(*result, *result, *b);
+        cell_set_mpz(&node->value.number, *result);
         /* snprintf(debug_msg, sizeof(debug_msg), "+!: Added %s to %s, now %s", 
                  mpz_get_str(NULL, 10, *b), node->name, mpz_get_str(NULL, 10, node->value.number));
         send_to_channel(debug_msg);
@@ -1591,9 +1624,11 @@ case OP_PLUSSTORE:
         if (stack->top < 0) {
             // Pas d'offset : *b est la valeur, ajout à l'index 0
             if (node->value.array.size > 0) {
-                mpz_add(node->value.array.data[0], node->value.array.data[0], *b);
+                cell_get_mpz(*result, &node->value.array.data[0]);
+                mpz_add(*result, *result, *b);
+                cell_set_mpz(&node->value.array.data[0], *result);
                 snprintf(debug_msg, sizeof(debug_msg), "+!: Added %s to %s[0], now %s", 
-                         mpz_get_str(NULL, 10, *b), node->name, mpz_get_str(NULL, 10, node->value.array.data[0]));
+                         mpz_get_str(NULL, 10, *b), node->name, mpz_get_str(NULL, 10, *result));
                 send_to_channel(debug_msg);
             } else {
                 set_error("+!: Array is empty");
@@ -1605,7 +1640,9 @@ case OP_PLUSSTORE:
             pop(stack, *result); // valeur à ajouter
             unsigned long offset = mpz_get_ui(*b); // *b est l'offset
             if (offset < node->value.array.size) {
-                mpz_add(node->value.array.data[offset], node->value.array.data[offset], *result);
+                cell_get_mpz(*a, &node->value.array.data[offset]);
+                mpz_add(*a, *a, *result);
+                cell_set_mpz(&node->value.array.data[offset], *a);
                 /*snprintf(debug_msg, sizeof(debug_msg), "+!: Added %s to %s[%lu], now %s", 
                          mpz_get_str(NULL, 10, *result), node->name, offset, 
                          mpz_get_str(NULL, 10, node->value.array.data[offset]));
@@ -1662,9 +1699,8 @@ case OP_CREATE:
                 currentenv->dictionary.words[dict_idx].string_count = 0;
                 MemoryNode *node = memory_get(&currentenv->memory_list, index);
                 if (node && node->type == TYPE_ARRAY) {
-                    node->value.array.data = (mpz_t *)malloc(sizeof(mpz_t));
-                    mpz_init(node->value.array.data[0]);
-                    mpz_set_ui(node->value.array.data[0], 0);
+                    node->value.array.data = (Cell *)malloc(sizeof(Cell));
+                    cell_init(&node->value.array.data[0]);
                     node->value.array.size = 1;
                 }
             } else {
@@ -1677,9 +1713,8 @@ case OP_CREATE:
                 currentenv->dictionary.words[dict_idx].string_count = 0;
                 MemoryNode *node = memory_get(&currentenv->memory_list, index);
                 if (node && node->type == TYPE_ARRAY) {
-                    node->value.array.data = (mpz_t *)malloc(sizeof(mpz_t));
-                    mpz_init(node->value.array.data[0]);
-                    mpz_set_ui(node->value.array.data[0], 0);
+                    node->value.array.data = (Cell *)malloc(sizeof(Cell));
+                    cell_init(&node->value.array.data[0]);
                     node->value.array.size = 1;
                 }
             }
@@ -1890,6 +1925,7 @@ if (strcmp(token, ":") == 0) {
     env->currentWord.name = strdup(next_token); // Déjà strdup ici
     env->currentWord.code_length = 0;
     env->currentWord.string_count = 0;
+    freeWordConstants(&env->currentWord); // Restes d’une définition avortée
     env->control_stack_top = 0;
     env->current_word_index = env->dictionary.count;
     if (env->dictionary.count >= env->dictionary.capacity) {
@@ -1929,6 +1965,8 @@ if (strcmp(token, ";") == 0) {
     env->currentWord.name = NULL; // Juste réinitialiser pour éviter une double libération
     env->currentWord.code_length = 0;
     env->currentWord.string_count = 0;
+    env->currentWord.constants = NULL; // Le pool appartient désormais au dictionnaire
+    env->currentWord.constant_count = 0;
     return;
 }
     // Récursion dans une définition
@@ -2282,9 +2320,20 @@ else if (strcmp(token, "ENDCASE") == 0) {
                 mpz_t test_num;
                 mpz_init(test_num);
                 if (mpz_set_str(test_num, token, 10) == 0) {
-                    instr.opcode = OP_PUSH;
-                    instr.operand = env->currentWord.string_count;
-                    env->currentWord.strings[env->currentWord.string_count++] = strdup(token);
+                    // Littéral parsé une seule fois : inline s’il tient dans un long, sinon dans le pool
+                    if (mpz_fits_slong_p(test_num)) {
+                        instr.opcode = OP_PUSH;
+                        instr.operand = mpz_get_si(test_num);
+                    } else {
+                        instr.opcode = OP_PUSH_BIG;
+                        instr.operand = addWordConstant(&env->currentWord, test_num);
+                        if (instr.operand < 0) {
+                            set_error("Literal allocation failed");
+                            env->compile_error = 1;
+                            mpz_clear(test_num);
+                            return;
+                        }
+                    }
                 } else {
                     char msg[512];
                     snprintf(msg, sizeof(msg), "Unknown word in definition: %s", token);
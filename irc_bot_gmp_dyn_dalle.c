@@ -9,16 +9,29 @@
 #include <gmp.h>
 #include <time.h>
 #include <ctype.h>
+#include <limits.h>
+#include <setjmp.h>
 #include "memory_forth.h"
 #include <netdb.h> 
 #include <curl/curl.h> 
 
-#define STACK_SIZE 1000
-#define WORD_CODE_SIZE 512
+#define STACK_SIZE 1000        // Limite par défaut des piles d’un utilisateur (STACK-LIMIT la change)
+#define STACK_LIMIT_MAX 65536  // Plus grande limite acceptée par STACK-LIMIT
+#define STACK_INITIAL 16       // Cellules allouées au premier empilement
 #define CONTROL_STACK_SIZE 100
+#define CASE_DENSE_MAX 1024   // Plage max de sélecteurs d’une table de CASE indexée directement
 #define MAX_STRING_SIZE 256
 #define MPZ_POOL_SIZE 3
+#define INLINE_MAX_SIZE 8     // Taille max (hors OP_END) d’un mot recopié à la place de son appel
+#define INLINE_MAX_DEPTH 4    // Profondeur max d’inlining imbriqué
+#define VERIFY_ROUNDS 8       // Passes de revérification des appelants après une redéfinition
+#define FRAME_STACK_MAX 65536 // Profondeur max d’appels de mots (pile de retour de la VM)
 #define BUFFER_SIZE 2048
+
+// Dispatch par goto calculé (GCC/Clang) ; -DFORTH_SWITCH_DISPATCH force le switch portable
+#if defined(__GNUC__) && !defined(FORTH_SWITCH_DISPATCH)
+#define FORTH_THREADED
+#endif
  
 #define SERVER "46.16.175.175" // default 
 #define PORT 6667
@@ -28,7 +41,7 @@
 
 // Après les #define et les includes
 typedef enum {
-    OP_PUSH, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_DUP, OP_SWAP, OP_OVER,
+    OP_PUSH, OP_PUSH_BIG, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_DUP, OP_SWAP, OP_OVER,
     OP_ROT, OP_DROP, OP_EQ, OP_LT, OP_GT, OP_AND, OP_OR, OP_NOT, OP_XOR, OP_I, OP_J,
     OP_DO, OP_LOOP, OP_BRANCH_FALSE, OP_BRANCH,
     OP_UNLOOP, OP_PLUS_LOOP, OP_SQRT, OP_CALL, OP_END, OP_DOT_QUOTE, OP_LITSTRING,
@@ -39,7 +52,18 @@ typedef enum {
     OP_PICK, OP_ROLL, OP_PLUSSTORE, OP_DEPTH, OP_TOP, OP_NIP, OP_MOD,
     OP_CREATE, OP_ALLOT, OP_RECURSE, OP_IRC_CONNECT, OP_IRC_SEND, OP_EMIT,
     OP_STRING, OP_QUOTE, OP_PRINT, OP_NUM_TO_BIN, OP_PRIME_TEST, OP_AGAIN,
-    OP_TO_R, OP_FROM_R, OP_R_FETCH, OP_UNTIL, OP_CLEAR_STACK, OP_CLOCK, OP_SEE, OP_2DROP,OP_IMAGE,OP_TEMP_IMAGE,OP_CLEAR_STRINGS,OP_DELAY
+    OP_TO_R, OP_FROM_R, OP_R_FETCH, OP_UNTIL, OP_CLEAR_STACK, OP_CLOCK, OP_SEE, OP_2DROP,OP_IMAGE,OP_TEMP_IMAGE,OP_CLEAR_STRINGS,OP_DELAY,
+    OP_LEAVE,
+    OP_FILL, OP_SUM, OP_MOVE, OP_COUNT_IF, OP_MAX, OP_DOT_PRODUCT, // Tableaux entiers en une instruction
+    OP_STACK_LIMIT,
+    // Superinstructions produites par optimizeCode à ";"
+    OP_SQUARE, OP_OVER_ADD, OP_PUSH_ADD, OP_PUSH_SUB, OP_PUSH_MUL,
+    OP_EQ_BRANCH_FALSE, OP_LT_BRANCH_FALSE, OP_I_ARRAY_FETCH,
+    OP_TAIL_CALL, // Appel terminal : saut sans empiler de trame
+    OP_CASE_DISPATCH, // CASE à OF littéraux : un saut par table (CaseTable)
+    OP_CATCH, OP_THROW,
+    OP_CATCH_END, // Retour normal du xt de CATCH (catch_end_word), pas un mot
+    OP_COUNT // Nombre d’opcodes, pas une instruction
 } OpCode;
 
 typedef struct {
@@ -47,27 +71,77 @@ typedef struct {
     long int operand;
 } Instruction;
 
+// Table d’un CASE dont les OF de tête comparent à des littéraux : sélecteur -> corps de l’OF.
+// Dense, targets est indexé par sélecteur - min ; sinon keys est trié (recherche dichotomique).
+typedef struct {
+    long int *keys;          // Sélecteurs triés (NULL si dense)
+    long int *targets;       // Adresse du corps, default_target pour un trou de la table dense
+    long int count;          // Entrées de targets
+    long int min;            // Plus petit sélecteur
+    long int default_target; // Premier OF non littéral, ou code par défaut avant ENDCASE
+} CaseTable;
+
 // Définir CompiledWord avant DynamicDictionary
+// En-tête d’un mot : code et chaînes sont des tableaux à leur taille exacte, pris dans l’arène
+// du dictionnaire (freeWordBody). Seul currentWord a des tableaux extensibles (emitInstruction).
 typedef struct {
     char *name;
-    Instruction code[WORD_CODE_SIZE];
+    Instruction *code;
     long int code_length;
-    char *strings[WORD_CODE_SIZE];
+    char **strings;        // Chaînes partagées (fstr_*), référencées aussi par la pile de chaînes
     long int string_count;
+    mpz_t *constants;      // Littéraux trop grands pour un long, parsés une fois à la compilation
+    long int constant_count;
+    void **threaded;       // Adresses des handlers (code_length + 1 entrées), construites à ";"
+    Instruction *source;   // Code compilé avant inlining et peephole (NULL si identique), pour SEE
+    long int source_length;
+    long int *inlined;     // Index des mots recopiés dans ce code, pour le recompiler s’ils changent
+    long int inlined_count;
+    CaseTable *case_tables; // Tables des OP_CASE_DISPATCH, construites par optimizeCode
+    long int case_table_count;
+    void **unchecked;      // Comme threaded, handlers sans contrôle de pile (mot vérifié seulement)
+    int verified;          // Effet sur la pile prouvé par verifyWord : ( stack_in -- stack_out )
+    long int stack_in;     // Profondeur lue sous le sommet d’entrée
+    long int stack_out;
+    long int stack_grow;   // Profondeur max au-dessus de l’entrée, appelés compris
+    int called;            // Appelé ou recopié par un autre mot : ses redéfinitions le touchent
     int immediate;
 } CompiledWord;
 
+// Case de l’index des noms : hachage du nom et numéro du mot (-1 si vide)
 typedef struct {
-    CompiledWord *words;   // Pointeur vers les mots alloués dynamiquement
-    long int count;        // Nombre de mots actuels
-    long int capacity;     // Capacité actuelle du tableau
+    unsigned long hash;
+    long int word;
+} DictSlot;
+
+// Dictionnaire d’un utilisateur : ses seuls mots, par-dessus le dictionnaire partagé des
+// builtins (lecture seule, commun à tous). Les numéros de mots forment un seul espace :
+// 0..base-1 pour les mots partagés, base..count-1 pour ceux de l’utilisateur (dictWord).
+typedef struct DynamicDictionary {
+    CompiledWord **words;  // En-têtes des mots propres (dans l’arène) : words[i - base] est le mot i
+    long int base;         // Nombre de mots partagés, avant le premier mot propre
+    long int count;        // Numéro du prochain mot (mots partagés compris)
+    long int capacity;     // base + mots propres alloués
+    DictSlot *index;       // Table de hachage nom -> mot propre (adressage ouvert, taille puissance de 2)
+    long int index_capacity;
+    long int index_used;
+    Arena *arena;          // Arène des noms (celle de l’Env), NULL pour malloc/free
+    struct DynamicDictionary *shared; // Dictionnaire des builtins, NULL pour lui-même
 } DynamicDictionary;
+
+static inline CompiledWord *dictWord(const DynamicDictionary *dict, long int idx) {
+    return idx < dict->base ? dict->shared->words[idx] : dict->words[idx - dict->base];
+}
  
  
-// Structure pour une pile Forth
+// Structure pour une pile Forth (cellules natives, promues en GMP au débordement)
+// Pile de cellules contiguë, allouée au premier empilement puis agrandie par doublement
+// jusqu’à limit. Les cellules neuves sont en représentation native (pas de mpz_init).
 typedef struct {
-    mpz_t data[STACK_SIZE];
+    Cell *data;
     long int top;
+    long int capacity; // Cellules allouées
+    long int limit;    // Profondeur max pour cet utilisateur
 } Stack;
 
 // Structure pour les structures de contrôle
@@ -93,111 +167,1273 @@ typedef struct {
     long int size;
 } Memory;
 
-#define LOOP_STACK_SIZE 16  // Taille max de la pile de boucles, ajustable
+#define LOOP_STACK_SIZE 256  // Taille max de la pile de boucles, ajustable
 
 typedef struct {
-    mpz_t index;    // Index actuel de la boucle
-    mpz_t limit;    // Limite de la boucle
+    Cell index;    // Index actuel de la boucle (natif tant qu'il tient dans un long)
+    Cell limit;    // Limite de la boucle
 } LoopEntry;
 
+// Trame d’appel de la VM : mot appelant et instruction où reprendre
+typedef struct {
+    CompiledWord *word;
+    long int ip;
+    int word_index; // -1 pour un mot hors dictionnaire (ligne interprétée)
+    int loop_top;   // Boucles DO ouvertes chez l’appelant, rétablies au retour
+    int unchecked;  // L’appelant tournait sur son code sans contrôles
+} Frame;
+
+// CATCH en cours : où reprendre et quelles profondeurs rétablir quand une erreur remonte jusqu’à lui
+typedef struct {
+    CompiledWord *word; // Mot qui a exécuté CATCH, repris juste après
+    long int ip;
+    int word_index;
+    int frame_top;
+    int loop_top;
+    long int return_top;
+    long int data_top;  // Profondeur de la pile de données sans le xt
+} CatchFrame;
+
+// Codes de THROW des erreurs internes (valeurs de Forth 2012), -1 pour les autres
+#define THROW_ABORT            -1
+#define THROW_STACK_OVERFLOW   -3
+#define THROW_STACK_UNDERFLOW  -4
+#define THROW_RSTACK_OVERFLOW  -5
+#define THROW_RSTACK_UNDERFLOW -6
+#define THROW_DIVISION_BY_ZERO -10
+
+// Pile de chaînes : slots recyclés par liste libre. Le handle laissé sur la pile de données
+// combine slot et génération ; la génération change à chaque libération, ce qui invalide
+// les anciens handles au lieu de les faire pointer sur une autre chaîne.
+#define STRING_SLOT_BITS 16  // 65536 >= STACK_LIMIT_MAX slots
+#define STRING_SLOT_MASK ((1L << STRING_SLOT_BITS) - 1)
+
+typedef struct {
+    char *str;      // Référence fstr, NULL pour @ sur une STRING jamais affectée
+    long int gen;   // Génération courante du slot
+    int next_free;  // Slot libre suivant (si !used), -1 en fin de liste
+    int used;
+} StringSlot;
+
+typedef struct GmpAccount GmpAccount; // Comptabilité des limbs GMP d’un utilisateur
+
 // Structure Env pour le multi-utilisateur
 typedef struct Env {
     char nick[MAX_STRING_SIZE];
     Stack main_stack;
     Stack return_stack;
-    LoopEntry loop_stack[LOOP_STACK_SIZE];
-    int loop_stack_top;
+    LoopEntry *loop_stack; // Boucles DO en cours, séparées de return_stack, allouées au premier DO
+    int loop_stack_top;    // Nombre de boucles ouvertes
+    int loop_capacity;
     DynamicDictionary dictionary; // Remplace CompiledWord dictionary[DICT_SIZE]
     MemoryList memory_list;
+    Arena arena; // Noms, chaînes compilées et nœuds mémoire de l’utilisateur, rendus d’un bloc
+    GmpAccount *gmp; // Octets de limbs GMP vivants et quota
     char output_buffer[BUFFER_SIZE];
     int buffer_pos;
     CompiledWord currentWord;
+    long int code_capacity;   // Instructions allouées pour currentWord.code (malloc, doublement)
+    long int string_capacity_word; // Idem pour currentWord.strings
     int compiling;
     int compile_error;
     long int current_word_index;
     ControlEntry control_stack[CONTROL_STACK_SIZE];
     int control_stack_top;
-    char *string_stack[STACK_SIZE];
-    int string_stack_top;
+    StringSlot *string_slots; // Alloués à la demande, jusqu’à main_stack.limit
+    int string_slots_used; // Slots déjà distribués (libres ou non)
+    int string_capacity;
+    int string_free_head;  // Premier slot libre à réutiliser, -1 sinon
     int error_flag;
     char emit_buffer[512];
     int emit_buffer_pos;
+    Frame *frames; // Pile d’appels de executeCompiledWord, allouée à la demande
+    int frame_top;
+    int frame_capacity;
+    jmp_buf *abort_point; // Reprise de l’exécution en cours (executeCompiledWord), NULL hors VM
+    CatchFrame *catches;  // CATCH en cours, alloués au premier CATCH
+    int catch_top;
+    int catch_capacity;
+    int catch_base;       // Premier CATCH de l’exécution en cours, ceux d’en dessous sont à un appelant
+    long int throw_code;  // Code de la dernière erreur, rendu par CATCH
     struct Env *next;
 } Env;
 
 void executeCompiledWord(CompiledWord *word, Stack *stack, int word_index);
-void executeInstruction(Instruction instr, Stack *stack, long int *ip, CompiledWord *word, int word_index);
 void interpret(char *input, Stack *stack);
 void compileToken(char *token, char **input_rest, Env *env);
 void send_to_channel(const char *msg) ;
+void set_error(const char *msg);
+void forth_throw(long int code, const char *msg);
+static void flag_error(long int code, const char *msg);
 
 // Variables globales
 Env *head = NULL;
 Env *currentenv = NULL;
 static int irc_socket = -1;
 mpz_t mpz_pool[MPZ_POOL_SIZE];
+Cell cell_pool[MPZ_POOL_SIZE];
 char * channel ; 
 
+// Allocation des limbs GMP : chaque bloc porte en en-tête le compte de l’utilisateur
+// qui l’a alloué, et les petits blocs sont recyclés par classes de taille.
+#ifndef GMP_QUOTA_BYTES
+#define GMP_QUOTA_BYTES (64UL * 1024 * 1024) // Limbs GMP vivants autorisés par utilisateur
+#endif
+#define GMP_POOL_MIN_SHIFT 5   // Plus petite classe : 32 octets, en-tête compris
+#define GMP_POOL_CLASSES   7   // 32 à 2048 octets
+#define GMP_POOL_KEEP      256 // Blocs libres gardés par classe
+
+// Un compte survit à son Env tant que des blocs (mpz_pool par exemple) lui sont encore attribués
+struct GmpAccount {
+    size_t live_bytes; // Octets demandés par GMP et pas encore rendus
+    size_t quota;
+    long int refs;     // Env propriétaire + blocs attribués
+};
+
+typedef struct {
+    GmpAccount *owner; // NULL hors de tout utilisateur
+    size_t pad;        // Garde les limbs alignés sur 16 octets
+} GmpHeader;
+
+static GmpHeader *gmp_pool[GMP_POOL_CLASSES];
+static int gmp_pool_count[GMP_POOL_CLASSES];
+
+// Classe du bloc, ou -1 s’il est trop grand pour le pool
+static int gmp_class(size_t size) {
+    size_t total = size + sizeof(GmpHeader);
+    int c = 0;
+    while (c < GMP_POOL_CLASSES && ((size_t)1 << (GMP_POOL_MIN_SHIFT + c)) < total) c++;
+    return c < GMP_POOL_CLASSES ? c : -1;
+}
+
+static void gmp_out_of_memory(void) {
+    fprintf(stderr, "GMP: out of memory\n");
+    abort();
+}
+
+static GmpHeader *gmp_block_get(size_t size) {
+    int c = gmp_class(size);
+    GmpHeader *h;
+    if (c >= 0 && gmp_pool[c]) {
+        h = gmp_pool[c];
+        gmp_pool[c] = *(GmpHeader **)(h + 1);
+        gmp_pool_count[c]--;
+    } else {
+        h = (GmpHeader *)malloc(c >= 0 ? (size_t)1 << (GMP_POOL_MIN_SHIFT + c) : sizeof(GmpHeader) + size);
+        if (!h) gmp_out_of_memory();
+    }
+    return h;
+}
+
+static void gmp_block_put(GmpHeader *h, size_t size) {
+    int c = gmp_class(size);
+    if (c >= 0 && gmp_pool_count[c] < GMP_POOL_KEEP) {
+        h->owner = NULL;
+        *(GmpHeader **)(h + 1) = gmp_pool[c];
+        gmp_pool[c] = h;
+        gmp_pool_count[c]++;
+    } else {
+        free(h);
+    }
+}
+
+static void gmp_account_release(GmpAccount *acc) {
+    if (acc && --acc->refs == 0) free(acc);
+}
+
+// Impute size octets à l’utilisateur courant ; au-delà du quota, le calcul en cours s’arrête sur une erreur Forth
+static GmpAccount *gmp_charge(size_t size) {
+    GmpAccount *acc = currentenv ? currentenv->gmp : NULL;
+    if (!acc) return NULL;
+    acc->refs++;
+    acc->live_bytes += size;
+    if (acc->live_bytes > acc->quota && !currentenv->error_flag) {
+        flag_error(THROW_ABORT, "Memory quota exceeded"); // Pas de longjmp dans GMP : relancée au prochain saut ou appel
+    }
+    return acc;
+}
+
+static void gmp_uncharge(GmpAccount *acc, size_t size) {
+    if (!acc) return;
+    acc->live_bytes -= size;
+    gmp_account_release(acc);
+}
+
+static void *gmp_alloc(size_t size) {
+    GmpHeader *h = gmp_block_get(size);
+    h->owner = gmp_charge(size);
+    return h + 1;
+}
+
+static void *gmp_realloc(void *ptr, size_t old_size, size_t new_size) {
+    GmpHeader *h = (GmpHeader *)ptr - 1;
+    gmp_uncharge(h->owner, old_size);
+    int old_class = gmp_class(old_size), new_class = gmp_class(new_size);
+    if (old_class >= 0 && old_class == new_class) {
+        // Même classe : le bloc reste en place
+    } else if (old_class < 0 && new_class < 0) {
+        h = (GmpHeader *)realloc(h, sizeof(GmpHeader) + new_size);
+        if (!h) gmp_out_of_memory();
+    } else {
+        GmpHeader *n = gmp_block_get(new_size);
+        memcpy(n + 1, h + 1, old_size < new_size ? old_size : new_size);
+        gmp_block_put(h, old_size);
+        h = n;
+    }
+    h->owner = gmp_charge(new_size);
+    return h + 1;
+}
+
+static void gmp_free(void *ptr, size_t size) {
+    if (!ptr) return;
+    GmpHeader *h = (GmpHeader *)ptr - 1;
+    gmp_uncharge(h->owner, size);
+    gmp_block_put(h, size);
+}
+
+// Compte auquel GMP a imputé les limbs de z, NULL s’il n’en a pas alloué
+static GmpAccount *gmp_owner(mpz_srcptr z) {
+    return z->_mp_alloc > 0 ? ((GmpHeader *)z->_mp_d - 1)->owner : NULL;
+}
+
+// Rend les limbs gardés par les cellules hors pile (au-dessus du sommet) et par les tampons
+// partagés (mpz_pool, cell_pool) imputés à env, pour qu’un dépassement de quota ne bloque pas
+// l’utilisateur. Aucun calcul ne doit être en cours.
+static void gmp_reclaim(Env *env) {
+    for (long int i = env->main_stack.top + 1; i < env->main_stack.capacity; i++) cell_clear(&env->main_stack.data[i]);
+    for (long int i = env->return_stack.top + 1; i < env->return_stack.capacity; i++) cell_clear(&env->return_stack.data[i]);
+    for (int i = env->loop_stack_top; i < env->loop_capacity; i++) {
+        cell_clear(&env->loop_stack[i].index);
+        cell_clear(&env->loop_stack[i].limit);
+    }
+    for (int i = 0; i < MPZ_POOL_SIZE; i++) {
+        if (gmp_owner(mpz_pool[i]) == env->gmp) {
+            mpz_clear(mpz_pool[i]);
+            mpz_init(mpz_pool[i]);
+        }
+        if (cell_pool[i].z_ready && gmp_owner(cell_pool[i].z) == env->gmp) cell_clear(&cell_pool[i]);
+    }
+}
+
+// Cellules que DROP, 2DROP ou CLEAR-STACK viennent de libérer (au-dessus du sommet jusqu’à
+// old_top) : gardées pour les prochains push, sauf au-delà du quota où leurs limbs sont rendus
+// avec tout ce que gmp_reclaim peut reprendre (appelé entre deux instructions)
+static inline void stack_release(Stack *stack, long int old_top) {
+    if (currentenv->gmp->live_bytes <= currentenv->gmp->quota) return;
+    for (long int i = stack->top + 1; i <= old_top; i++) cell_clear(&stack->data[i]);
+    gmp_reclaim(currentenv);
+}
+
 // Fonctions utilitaires
 void init_mpz_pool() {
-    for (int i = 0; i < MPZ_POOL_SIZE; i++) mpz_init(mpz_pool[i]);
+    mp_set_memory_functions(gmp_alloc, gmp_realloc, gmp_free); // Avant tout mpz_init
+    for (int i = 0; i < MPZ_POOL_SIZE; i++) {
+        mpz_init(mpz_pool[i]);
+        cell_init(&cell_pool[i]);
+    }
 }
 
 void clear_mpz_pool() {
-    for (int i = 0; i < MPZ_POOL_SIZE; i++) mpz_clear(mpz_pool[i]);
-}
-void executeCompiledWord(CompiledWord *word, Stack *stack, int word_index) {
-    long int ip = 0;
-    while (ip < word->code_length && !currentenv->error_flag) {
-        executeInstruction(word->code[ip], stack, &ip, word, word_index);
-        ip++;
+    for (int i = 0; i < MPZ_POOL_SIZE; i++) {
+        mpz_clear(mpz_pool[i]);
+        cell_clear(&cell_pool[i]);
     }
 }
  
-void initDynamicDictionary(DynamicDictionary *dict) {
-    dict->capacity = 16; // Capacité initiale, ajustable
-    dict->count = 0;
-    dict->words = (CompiledWord *)malloc(dict->capacity * sizeof(CompiledWord));
+// Hachage FNV-1a des noms de mots
+static unsigned long hashName(const char *name) {
+    unsigned long h = 14695981039346656037UL;
+    while (*name) {
+        h ^= (unsigned char)*name++;
+        h *= 1099511628211UL;
+    }
+    return h;
+}
+
+// Mots primitifs : une seule table pour le dictionnaire partagé, compileToken et le désassembleur de SEE.
+// PRIM_DICT : entrée du dictionnaire (dans cet ordre) ; PRIM_IMMEDIATE : exécuté même dans ":" ;
+// PRIM_INLINE : compilé directement en opcode dans ":", sans passer par le dictionnaire ;
+// PRIM_SYNTAX : traitement propre dans compileToken (structures de contrôle, chaînes, VARIABLE).
+#define PRIM_DICT      1
+#define PRIM_IMMEDIATE 2
+#define PRIM_INLINE    4
+#define PRIM_SYNTAX    8
+
+#define FORTH_PRIMITIVES(X) \
+    X(".S",            OP_DOT_S,         PRIM_DICT | PRIM_INLINE) \
+    X(".",             OP_DOT,           PRIM_DICT | PRIM_INLINE) \
+    X("+",             OP_ADD,           PRIM_DICT | PRIM_INLINE) \
+    X("-",             OP_SUB,           PRIM_DICT | PRIM_INLINE) \
+    X("*",             OP_MUL,           PRIM_DICT | PRIM_INLINE) \
+    X("/",             OP_DIV,           PRIM_DICT | PRIM_INLINE) \
+    X("MOD",           OP_MOD,           PRIM_DICT | PRIM_INLINE) \
+    X("DUP",           OP_DUP,           PRIM_DICT | PRIM_INLINE) \
+    X("DROP",          OP_DROP,          PRIM_DICT | PRIM_INLINE) \
+    X("SWAP",          OP_SWAP,          PRIM_DICT | PRIM_INLINE) \
+    X("OVER",          OP_OVER,          PRIM_DICT | PRIM_INLINE) \
+    X("ROT",           OP_ROT,           PRIM_DICT | PRIM_INLINE) \
+    X(">R",            OP_TO_R,          PRIM_DICT | PRIM_INLINE) \
+    X("R>",            OP_FROM_R,        PRIM_DICT | PRIM_INLINE) \
+    X("R@",            OP_R_FETCH,       PRIM_DICT | PRIM_INLINE) \
+    X("=",             OP_EQ,            PRIM_DICT | PRIM_INLINE) \
+    X("<",             OP_LT,            PRIM_DICT | PRIM_INLINE) \
+    X(">",             OP_GT,            PRIM_DICT | PRIM_INLINE) \
+    X("AND",           OP_AND,           PRIM_DICT | PRIM_INLINE) \
+    X("OR",            OP_OR,            PRIM_DICT | PRIM_INLINE) \
+    X("NOT",           OP_NOT,           PRIM_DICT | PRIM_INLINE) \
+    X("XOR",           OP_XOR,           PRIM_DICT | PRIM_INLINE) \
+    X("&",             OP_BIT_AND,       PRIM_DICT | PRIM_INLINE) \
+    X("|",             OP_BIT_OR,        PRIM_DICT | PRIM_INLINE) \
+    X("^",             OP_BIT_XOR,       PRIM_DICT | PRIM_INLINE) \
+    X("~",             OP_BIT_NOT,       PRIM_DICT | PRIM_INLINE) \
+    X("<<",            OP_LSHIFT,        PRIM_DICT | PRIM_INLINE) \
+    X(">>",            OP_RSHIFT,        PRIM_DICT | PRIM_INLINE) \
+    X("CR",            OP_CR,            PRIM_DICT | PRIM_INLINE) \
+    X("EMIT",          OP_EMIT,          PRIM_DICT | PRIM_INLINE) \
+    X("VARIABLE",      OP_VARIABLE,      PRIM_DICT | PRIM_SYNTAX) \
+    X("@",             OP_FETCH,         PRIM_DICT | PRIM_INLINE) \
+    X("!",             OP_STORE,         PRIM_DICT | PRIM_INLINE) \
+    X("+!",            OP_PLUSSTORE,     PRIM_DICT) \
+    X("DO",            OP_DO,            PRIM_DICT | PRIM_SYNTAX) \
+    X("LOOP",          OP_LOOP,          PRIM_DICT | PRIM_SYNTAX) \
+    X("I",             OP_I,             PRIM_DICT | PRIM_INLINE) \
+    X("WORDS",         OP_WORDS,         PRIM_DICT | PRIM_INLINE) \
+    X("LOAD",          OP_LOAD,          PRIM_DICT) \
+    X("CREATE",        OP_CREATE,        PRIM_DICT) \
+    X("ALLOT",         OP_ALLOT,         PRIM_DICT) \
+    X(".\"",           OP_DOT_QUOTE,     PRIM_DICT | PRIM_SYNTAX) \
+    X("CLOCK",         OP_CLOCK,         PRIM_DICT | PRIM_INLINE) \
+    X("BEGIN",         OP_BEGIN,         PRIM_DICT | PRIM_SYNTAX) \
+    X("WHILE",         OP_WHILE,         PRIM_DICT | PRIM_SYNTAX) \
+    X("REPEAT",        OP_REPEAT,        PRIM_DICT | PRIM_SYNTAX) \
+    X("AGAIN",         OP_AGAIN,         PRIM_DICT | PRIM_SYNTAX) \
+    X("SQRT",          OP_SQRT,          PRIM_DICT) \
+    X("UNLOOP",        OP_UNLOOP,        PRIM_DICT) \
+    X("LEAVE",         OP_LEAVE,         PRIM_DICT | PRIM_SYNTAX) \
+    X("+LOOP",         OP_PLUS_LOOP,     PRIM_DICT | PRIM_SYNTAX) \
+    X("PICK",          OP_PICK,          PRIM_DICT | PRIM_INLINE) \
+    X("CLEAR-STACK",   OP_CLEAR_STACK,   PRIM_DICT | PRIM_INLINE) \
+    X("PRINT",         OP_PRINT,         PRIM_DICT) \
+    X("NUM-TO-BIN",    OP_NUM_TO_BIN,    PRIM_DICT | PRIM_INLINE) \
+    X("PRIME?",        OP_PRIME_TEST,    PRIM_DICT | PRIM_INLINE) \
+    X("FORGET",        OP_FORGET,        PRIM_DICT | PRIM_IMMEDIATE) \
+    X("STRING",        OP_STRING,        PRIM_DICT | PRIM_IMMEDIATE) \
+    X("\"",            OP_QUOTE,         PRIM_DICT | PRIM_SYNTAX) \
+    X("2DROP",         OP_2DROP,         PRIM_DICT) \
+    X("IMAGE",         OP_IMAGE,         PRIM_DICT) \
+    X("TEMP-IMAGE",    OP_TEMP_IMAGE,    PRIM_DICT) \
+    X("CLEAR-STRINGS", OP_CLEAR_STRINGS, PRIM_DICT) \
+    X("DELAY",         OP_DELAY,         PRIM_DICT) \
+    X("EXIT",          OP_EXIT,          PRIM_DICT | PRIM_INLINE) \
+    X("FILL",          OP_FILL,          PRIM_DICT) \
+    X("SUM",           OP_SUM,           PRIM_DICT) \
+    X("MOVE",          OP_MOVE,          PRIM_DICT) \
+    X("COUNT-IF",      OP_COUNT_IF,      PRIM_DICT) \
+    X("MAX",           OP_MAX,           PRIM_DICT) \
+    X("DOT-PRODUCT",   OP_DOT_PRODUCT,   PRIM_DICT) \
+    X("STACK-LIMIT",   OP_STACK_LIMIT,   PRIM_DICT) \
+    X("CATCH",         OP_CATCH,         PRIM_DICT | PRIM_INLINE) \
+    X("THROW",         OP_THROW,         PRIM_DICT | PRIM_INLINE) \
+    X("J",             OP_J,             PRIM_INLINE) \
+    X("IF",            OP_BRANCH_FALSE,  PRIM_SYNTAX) \
+    X("ELSE",          OP_BRANCH,        PRIM_SYNTAX) \
+    X("THEN",          OP_COUNT,         PRIM_SYNTAX) \
+    X("UNTIL",         OP_UNTIL,         PRIM_SYNTAX) \
+    X("CASE",          OP_CASE,          PRIM_SYNTAX) \
+    X("OF",            OP_OF,            PRIM_SYNTAX) \
+    X("ENDOF",         OP_ENDOF,         PRIM_SYNTAX) \
+    X("ENDCASE",       OP_ENDCASE,       PRIM_SYNTAX)
+
+typedef struct {
+    const char *name;
+    OpCode opcode;
+    int flags;
+} Primitive;
+
+static const Primitive primitives[] = {
+#define X(name, opcode, flags) { name, opcode, flags },
+    FORTH_PRIMITIVES(X)
+#undef X
+};
+#define PRIMITIVE_COUNT (sizeof(primitives) / sizeof(primitives[0]))
+#define PRIMITIVE_INDEX_SIZE 256 // Puissance de 2, au moins le double de PRIMITIVE_COUNT
+
+static short primitive_index[PRIMITIVE_INDEX_SIZE]; // Rang dans primitives[] + 1, 0 si vide
+static const char *primitive_names[OP_COUNT];       // Nom affiché par SEE pour un opcode simple
+static int primitives_ready = 0;
+
+static void initPrimitives(void) {
+    primitives_ready = 1;
+    for (size_t i = 0; i < PRIMITIVE_COUNT; i++) {
+        unsigned long h = hashName(primitives[i].name) & (PRIMITIVE_INDEX_SIZE - 1);
+        while (primitive_index[h]) h = (h + 1) & (PRIMITIVE_INDEX_SIZE - 1);
+        primitive_index[h] = i + 1;
+        OpCode op = primitives[i].opcode;
+        if ((primitives[i].flags & (PRIM_DICT | PRIM_INLINE)) && op < OP_COUNT && !primitive_names[op]) {
+            primitive_names[op] = primitives[i].name;
+        }
+    }
+}
+
+// Mot-clé primitif de nom token, ou NULL
+static const Primitive *findPrimitive(const char *token) {
+    if (!primitives_ready) initPrimitives();
+    for (unsigned long h = hashName(token) & (PRIMITIVE_INDEX_SIZE - 1); primitive_index[h];
+         h = (h + 1) & (PRIMITIVE_INDEX_SIZE - 1)) {
+        const Primitive *prim = &primitives[primitive_index[h] - 1];
+        if (strcmp(prim->name, token) == 0) return prim;
+    }
+    return NULL;
+}
+
+// Place le mot idx dans l’index sans l’agrandir. Un homonyme déjà indexé est
+// remplacé : la définition la plus récente masque les anciennes.
+static void dictIndexInsert(DynamicDictionary *dict, long int idx) {
+    const char *name = dictWord(dict, idx)->name;
+    unsigned long h = hashName(name), mask = dict->index_capacity - 1;
+    for (unsigned long i = h & mask; ; i = (i + 1) & mask) {
+        DictSlot *slot = &dict->index[i];
+        if (slot->word < 0) {
+            slot->hash = h;
+            slot->word = idx;
+            dict->index_used++;
+            return;
+        }
+        if (slot->word == idx) return;
+        if (slot->hash == h && slot->word < dict->count && dictWord(dict, slot->word)->name &&
+            strcmp(dictWord(dict, slot->word)->name, name) == 0) {
+            slot->word = idx;
+            return;
+        }
+    }
+}
+
+// Reconstruit l’index depuis les noms des mots propres (création, agrandissement, FORGET)
+void dictIndexRebuild(DynamicDictionary *dict) {
+    long int capacity = 64;
+    while (capacity < (dict->count - dict->base) * 2 + 16) capacity *= 2;
+    DictSlot *index = malloc(capacity * sizeof(DictSlot));
+    if (!index) {
+        send_to_channel("Erreur : Échec de l’allocation de l’index du dictionnaire");
+        exit(1);
+    }
+    for (long int i = 0; i < capacity; i++) index[i].word = -1;
+    free(dict->index);
+    dict->index = index;
+    dict->index_capacity = capacity;
+    dict->index_used = 0;
+    for (long int i = dict->base; i < dict->count; i++) {
+        if (dictWord(dict, i)->name) dictIndexInsert(dict, i);
+    }
+}
+
+// Indexe un mot qui vient de recevoir son nom
+void dictIndexAdd(DynamicDictionary *dict, long int idx) {
+    if (!dictWord(dict, idx)->name) return;
+    if ((dict->index_used + 1) * 2 > dict->index_capacity) dictIndexRebuild(dict);
+    dictIndexInsert(dict, idx);
+}
+
+// Numéro du mot nommé name, ou -1 : mots propres d’abord, qui masquent les builtins.
+// Les cases dont le mot a perdu son nom (redéfinition en cours, FORGET) sont ignorées.
+long int dictLookup(const DynamicDictionary *dict, const char *name) {
+    unsigned long h = hashName(name), mask = dict->index_capacity - 1;
+    for (unsigned long i = h & mask; dict->index[i].word >= 0; i = (i + 1) & mask) {
+        long int w = dict->index[i].word;
+        if (dict->index[i].hash == h && w < dict->count && dictWord(dict, w)->name &&
+            strcmp(dictWord(dict, w)->name, name) == 0) return w;
+    }
+    return dict->shared ? dictLookup(dict->shared, name) : -1;
+}
+
+// Comme dictLookup, sans les builtins : un nom partagé redéfini reçoit un mot propre
+long int dictLookupOwn(const DynamicDictionary *dict, const char *name) {
+    long int w = dictLookup(dict, name);
+    return w >= dict->base ? w : -1;
+}
+
+// En-têtes vides pour les emplacements from..to-1 des mots propres
+static void allocWordHeaders(DynamicDictionary *dict, long int from, long int to) {
+    for (long int i = from; i < to; i++) {
+        dict->words[i] = (CompiledWord *)arena_alloc(dict->arena, sizeof(CompiledWord));
+        if (!dict->words[i]) {
+            send_to_channel("Erreur : Échec de l’allocation du dictionnaire");
+            exit(1); // Ou gérer autrement
+        }
+        memset(dict->words[i], 0, sizeof(CompiledWord));
+    }
+}
+
+void initDynamicDictionary(DynamicDictionary *dict, DynamicDictionary *shared, Arena *arena) {
+    dict->shared = shared;
+    dict->base = shared ? shared->count : 0;
+    dict->count = dict->base;
+    dict->capacity = dict->base + 4; // Un nouvel utilisateur n’a que USERNAME
+    dict->arena = arena;
+    dict->words = (CompiledWord **)malloc(4 * sizeof(CompiledWord *));
     if (!dict->words) {
         send_to_channel("Erreur : Échec de l’allocation du dictionnaire");
         exit(1); // Ou gérer autrement
     }
-    for (long int i = 0; i < dict->capacity; i++) {
-        dict->words[i].name = NULL;
-        dict->words[i].code_length = 0;
-        dict->words[i].string_count = 0;
-        dict->words[i].immediate = 0;
-    }
+    allocWordHeaders(dict, 0, 4);
+    dict->index = NULL;
+    dict->index_capacity = 0;
+    dict->index_used = 0;
+    dictIndexRebuild(dict);
 }
 
+// Seuls les pointeurs d’en-têtes sont recopiés : les mots ne bougent pas
 void resizeDynamicDictionary(DynamicDictionary *dict) {
-    long int new_capacity = dict->capacity * 2;
-    CompiledWord *new_words = (CompiledWord *)realloc(dict->words, new_capacity * sizeof(CompiledWord));
+    long int own = dict->capacity - dict->base, new_own = own * 2;
+    CompiledWord **new_words = (CompiledWord **)realloc(dict->words, new_own * sizeof(CompiledWord *));
     if (!new_words) {
         send_to_channel("Erreur : Échec du redimensionnement du dictionnaire");
         exit(1); // Ou gérer autrement
     }
     dict->words = new_words;
-    for (long int i = dict->count; i < new_capacity; i++) {
-        dict->words[i].name = NULL;
-        dict->words[i].code_length = 0;
-        dict->words[i].string_count = 0;
-        dict->words[i].immediate = 0;
+    allocWordHeaders(dict, own, new_own);
+    dict->capacity = dict->base + new_own;
+}
+
+// Rend à l’arène le code et la table de chaînes d’un mot (les références des chaînes
+// sont libérées par l’appelant)
+void freeWordBody(CompiledWord *word, Arena *arena) {
+    if (word->code) arena_free(arena, word->code, word->code_length * sizeof(Instruction));
+    if (word->strings) arena_free(arena, word->strings, word->string_count * sizeof(char *));
+    word->code = NULL;
+    word->code_length = 0;
+    word->strings = NULL;
+    word->string_count = 0;
+}
+
+// Remplace le code d’un mot par une seule instruction (builtins, variables, tableaux, chaînes)
+void setWordInstruction(DynamicDictionary *dict, CompiledWord *word, OpCode opcode, long int operand) {
+    if (word->code) arena_free(dict->arena, word->code, word->code_length * sizeof(Instruction));
+    word->code = (Instruction *)arena_alloc(dict->arena, sizeof(Instruction));
+    if (!word->code) {
+        word->code_length = 0;
+        set_error("Word code allocation failed");
+        return;
     }
-    dict->capacity = new_capacity;
+    word->code[0].opcode = opcode;
+    word->code[0].operand = operand;
+    word->code_length = 1;
 }
 
+static int isBranchOp(OpCode op);
+
 void addWord(DynamicDictionary *dict, const char *name, OpCode opcode, int immediate) {
     if (dict->count >= dict->capacity) {
         resizeDynamicDictionary(dict);
     }
-    CompiledWord *word = &dict->words[dict->count];
-    word->name = strdup(name);
-    word->code[0].opcode = opcode;
-    word->code_length = 1;
+    CompiledWord *word = dictWord(dict, dict->count);
+    word->name = arena_strdup(dict->arena, name);
+    // Un saut exécuté hors définition (REPEAT, AGAIN…) n’a pas de cible : VM_JUMP le refuse
+    setWordInstruction(dict, word, opcode, isBranchOp(opcode) ? -1 : 0);
     word->string_count = 0;
     word->immediate = immediate;
     dict->count++;
+    dictIndexAdd(dict, dict->count - 1);
+}
+
+// Dictionnaire des builtins, construit au premier appel puis partagé par tous les utilisateurs.
+// Seul threaded y est encore écrit, au premier appel de chaque mot.
+DynamicDictionary *builtinDictionary(void) {
+    static DynamicDictionary builtins;
+    static int ready = 0;
+    if (!ready) {
+        ready = 1;
+        initDynamicDictionary(&builtins, NULL, NULL);
+        for (size_t i = 0; i < PRIMITIVE_COUNT; i++) {
+            if (primitives[i].flags & PRIM_DICT) {
+                addWord(&builtins, primitives[i].name, primitives[i].opcode, (primitives[i].flags & PRIM_IMMEDIATE) != 0);
+            }
+        }
+    }
+    return &builtins;
+}
+
+void freeCaseTables(CompiledWord *word) {
+    for (long int i = 0; i < word->case_table_count; i++) {
+        free(word->case_tables[i].keys);
+        free(word->case_tables[i].targets);
+    }
+    free(word->case_tables);
+    word->case_tables = NULL;
+    word->case_table_count = 0;
+}
+
+void freeWordCode(CompiledWord *word) {
+    for (long int i = 0; i < word->constant_count; i++) mpz_clear(word->constants[i]);
+    free(word->constants);
+    word->constants = NULL;
+    word->constant_count = 0;
+    free(word->threaded);
+    word->threaded = NULL;
+    free(word->unchecked);
+    word->unchecked = NULL;
+    word->verified = 0;
+    free(word->source);
+    word->source = NULL;
+    word->source_length = 0;
+    free(word->inlined);
+    word->inlined = NULL;
+    word->inlined_count = 0;
+    freeCaseTables(word);
+}
+
+#ifdef FORTH_THREADED
+static void **vm_dispatch_table = NULL;  // Exportée par executeCompiledWord(NULL, ...)
+static void **vm_unchecked_table = NULL; // Idem, handlers d’entrée sans contrôle de pile
+
+static void **fillThreaded(const CompiledWord *word, void **table) {
+    void **threaded = malloc((word->code_length + 1) * sizeof(void *));
+    if (!threaded) return NULL;
+    for (long int i = 0; i < word->code_length; i++) {
+        OpCode op = word->code[i].opcode;
+        threaded[i] = table[(op >= 0 && op < OP_COUNT) ? op : OP_COUNT + 1];
+    }
+    threaded[word->code_length] = table[OP_COUNT]; // Fin du mot
+    return threaded;
+}
+#endif
+
+// Traduit le code d’un mot en tableau d’adresses de handlers (une fois, à ";" ou au premier appel).
+// Un mot vérifié a en plus son code sans contrôles, pris quand la profondeur d’entrée suffit.
+int threadWord(CompiledWord *word) {
+#ifdef FORTH_THREADED
+    if (!vm_dispatch_table) executeCompiledWord(NULL, NULL, -1);
+    free(word->unchecked);
+    word->unchecked = NULL;
+    void **threaded = fillThreaded(word, vm_dispatch_table);
+    if (!threaded) return 0;
+    free(word->threaded);
+    word->threaded = threaded;
+    if (word->verified) word->unchecked = fillThreaded(word, vm_unchecked_table); // NULL : contrôles gardés
+#else
+    (void)word;
+#endif
+    return 1;
+}
+
+// Opcodes dont l’opérande est une adresse de saut dans le mot
+static int isBranchOp(OpCode op) {
+    switch (op) {
+        case OP_BRANCH: case OP_BRANCH_FALSE: case OP_LOOP: case OP_PLUS_LOOP:
+        case OP_OF: case OP_ENDOF: case OP_WHILE: case OP_REPEAT: case OP_UNTIL: case OP_AGAIN:
+        case OP_EQ_BRANCH_FALSE: case OP_LT_BRANCH_FALSE: case OP_LEAVE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+typedef struct {
+    long int key;
+    long int target;
+    long int order; // Rang de l’OF : à sélecteur égal, le premier l’emporte
+} CaseEntry;
+
+static int compareCaseEntries(const void *pa, const void *pb) {
+    const CaseEntry *a = pa, *b = pb;
+    if (a->key != b->key) return a->key < b->key ? -1 : 1;
+    return (a->order > b->order) - (a->order < b->order);
+}
+
+// Table d’un CASE compilé à l’adresse at (marqueur OP_CASE) : suit la chaîne "littéral OF … ENDOF"
+// tant que chaque OF suit un OP_PUSH. 0 si la chaîne ne commence pas ainsi ou si une allocation échoue.
+static int buildCaseTable(const Instruction *code, long int n, long int at, CaseTable *table) {
+    CaseEntry *entries = NULL;
+    long int count = 0, capacity = 0, pos = at + 1, endcase = -1;
+    while (pos + 1 < n && code[pos].opcode == OP_PUSH && code[pos + 1].opcode == OP_OF) {
+        long int next = code[pos + 1].operand; // Après l’ENDOF de cet OF
+        if (next < pos + 3 || next > n || code[next - 1].opcode != OP_ENDOF) break;
+        if (endcase >= 0 && code[next - 1].operand != endcase) break;
+        endcase = code[next - 1].operand;
+        if (count >= capacity) {
+            capacity = capacity ? capacity * 2 : 8;
+            CaseEntry *grown = realloc(entries, capacity * sizeof(CaseEntry));
+            if (!grown) {
+                free(entries);
+                return 0;
+            }
+            entries = grown;
+        }
+        entries[count].key = code[pos].operand;
+        entries[count].target = pos + 2;
+        entries[count].order = count;
+        count++;
+        pos = next;
+    }
+    if (count == 0 || endcase < pos || endcase >= n || code[endcase].opcode != OP_ENDCASE) {
+        free(entries);
+        return 0;
+    }
+    qsort(entries, count, sizeof(CaseEntry), compareCaseEntries);
+    long int unique = 0;
+    for (long int i = 0; i < count; i++) {
+        if (unique == 0 || entries[i].key != entries[unique - 1].key) entries[unique++] = entries[i];
+    }
+    // Écart en non signé : max - min ne déborde pas, mais + 1 repasse à 0 sur toute la plage
+    // de long (LONG_MIN et LONG_MAX comme clés), d’où le test avant d’ajouter 1
+    unsigned long range = (unsigned long)entries[unique - 1].key - (unsigned long)entries[0].key;
+    int dense = range < CASE_DENSE_MAX && range < 2 * (unsigned long)unique + 8;
+    table->min = entries[0].key;
+    table->default_target = pos;
+    table->count = dense ? (long int)range + 1 : unique;
+    table->keys = dense ? NULL : malloc(unique * sizeof(long int));
+    table->targets = malloc(table->count * sizeof(long int));
+    if (!table->targets || (!dense && !table->keys)) {
+        free(table->keys);
+        free(table->targets);
+        free(entries);
+        return 0;
+    }
+    if (dense) {
+        for (long int i = 0; i < table->count; i++) table->targets[i] = pos;
+        for (long int i = 0; i < unique; i++) table->targets[entries[i].key - table->min] = entries[i].target;
+    } else {
+        for (long int i = 0; i < unique; i++) {
+            table->keys[i] = entries[i].key;
+            table->targets[i] = entries[i].target;
+        }
+    }
+    free(entries);
+    return 1;
+}
+
+// Adresse où saute OP_CASE_DISPATCH pour ce sélecteur (laissé sur la pile, comme OF)
+static long int caseTarget(const CaseTable *table, const Cell *selector) {
+    if (selector->tag == CELL_BIG && !mpz_fits_slong_p(selector->z)) return table->default_target;
+    long int v = cell_get_si(selector);
+    if (!table->keys) {
+        unsigned long i = (unsigned long)v - (unsigned long)table->min;
+        return i < (unsigned long)table->count ? table->targets[i] : table->default_target;
+    }
+    long int lo = 0, hi = table->count - 1;
+    while (lo <= hi) {
+        long int mid = lo + (hi - lo) / 2;
+        if (table->keys[mid] == v) return table->targets[mid];
+        if (table->keys[mid] < v) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return table->default_target;
+}
+
+// Remplace les marqueurs CASE dont la chaîne d’OF commence par des littéraux par OP_CASE_DISPATCH.
+// Les "littéral OF" ainsi court-circuités restent dans le code (SEE) mais ne s’exécutent plus.
+static void compileCaseTables(CompiledWord *word, Instruction *code, long int n) {
+    for (long int i = 0; i < n; i++) {
+        if (code[i].opcode != OP_CASE) continue;
+        CaseTable table;
+        if (!buildCaseTable(code, n, i, &table)) continue;
+        CaseTable *tables = realloc(word->case_tables, (word->case_table_count + 1) * sizeof(CaseTable));
+        if (!tables) {
+            free(table.keys);
+            free(table.targets);
+            return;
+        }
+        word->case_tables = tables;
+        word->case_tables[word->case_table_count] = table;
+        code[i].opcode = OP_CASE_DISPATCH;
+        code[i].operand = word->case_table_count++;
+    }
+}
+
+// Peephole : fusionne les séquences fréquentes en superinstructions, sur place, et retire
+// les marqueurs BEGIN et CASE (ou les change en OP_CASE_DISPATCH). Aucune fusion ne traverse
+// une cible de saut ; les cibles, y compris celles des tables de CASE, sont renumérotées.
+// Renvoie la nouvelle longueur (n inchangé si les tables de travail n’ont pu être allouées).
+static long int optimizeCode(CompiledWord *word, Instruction *code, long int n, DynamicDictionary *dict) {
+    char *is_target = calloc(n + 1, 1);
+    long int *new_ip = malloc((n + 1) * sizeof(long int));
+    long int m = 0;
+    if (!is_target || !new_ip) {
+        free(is_target);
+        free(new_ip);
+        return n;
+    }
+
+    compileCaseTables(word, code, n);
+    for (long int i = 0; i < n; i++) {
+        if (isBranchOp(code[i].opcode) && code[i].operand >= 0 && code[i].operand <= n) {
+            is_target[code[i].operand] = 1;
+        }
+    }
+    for (long int t = 0; t < word->case_table_count; t++) {
+        CaseTable *table = &word->case_tables[t];
+        for (long int k = 0; k < table->count; k++) is_target[table->targets[k]] = 1;
+        is_target[table->default_target] = 1;
+    }
+    for (long int i = 0; i < n; ) {
+        if (code[i].opcode == OP_BEGIN || code[i].opcode == OP_CASE) {
+            new_ip[i++] = m; // Marqueur de SEE : les sauts vers lui vont à l’instruction suivante
+            continue;
+        }
+        Instruction fused = code[i];
+        int len = 1;
+        if (i + 1 < n && !is_target[i + 1]) {
+            OpCode op = code[i].opcode, next = code[i + 1].opcode;
+            if (op == OP_DUP && next == OP_MUL) {
+                fused.opcode = OP_SQUARE; len = 2;
+            } else if (op == OP_OVER && next == OP_ADD) {
+                fused.opcode = OP_OVER_ADD; len = 2;
+            } else if (op == OP_PUSH && (next == OP_ADD || next == OP_SUB || next == OP_MUL)) {
+                fused.opcode = next == OP_ADD ? OP_PUSH_ADD : next == OP_SUB ? OP_PUSH_SUB : OP_PUSH_MUL;
+                len = 2;
+            } else if ((op == OP_EQ || op == OP_LT) && next == OP_BRANCH_FALSE) {
+                fused.opcode = op == OP_EQ ? OP_EQ_BRANCH_FALSE : OP_LT_BRANCH_FALSE;
+                fused.operand = code[i + 1].operand;
+                len = 2;
+            } else if (op == OP_I && (next == OP_CALL || next == OP_PUSH) && i + 2 < n && !is_target[i + 2] &&
+                       code[i + 2].opcode == OP_FETCH) {
+                // Index mémoire du tableau : littéral (variable inlinée) ou mot CREATE appelé
+                const Instruction *ref = &code[i + 1];
+                if (next == OP_CALL) {
+                    long int callee = ref->operand;
+                    ref = (callee >= 0 && callee < dict->count && dictWord(dict, callee)->code_length == 1 &&
+                           dictWord(dict, callee)->code[0].opcode == OP_PUSH) ? &dictWord(dict, callee)->code[0] : NULL;
+                }
+                if (ref && ref->operand >= 0 && memory_get_type(ref->operand) == TYPE_ARRAY) {
+                    fused.opcode = OP_I_ARRAY_FETCH;
+                    fused.operand = ref->operand;
+                    len = 3;
+                }
+            }
+        }
+        for (int k = 0; k < len; k++) new_ip[i + k] = m;
+        code[m++] = fused; // m <= i : sur place, rien de ce qui reste à lire n’est écrasé
+        i += len;
+    }
+    new_ip[n] = m;
+    if (m != n) {
+        for (long int j = 0; j < m; j++) {
+            if (isBranchOp(code[j].opcode) && code[j].operand >= 0 && code[j].operand <= n) {
+                code[j].operand = new_ip[code[j].operand];
+            }
+        }
+        for (long int t = 0; t < word->case_table_count; t++) {
+            CaseTable *table = &word->case_tables[t];
+            for (long int k = 0; k < table->count; k++) table->targets[k] = new_ip[table->targets[k]];
+            table->default_target = new_ip[table->default_target];
+        }
+    }
+    free(is_target);
+    free(new_ip);
+    // Appel suivi d’une sortie : l’appelé reprend la trame de l’appelant
+    for (long int j = 0; j + 1 < m; j++) {
+        if (code[j].opcode == OP_CALL && (code[j + 1].opcode == OP_END || code[j + 1].opcode == OP_EXIT)) {
+            code[j].opcode = OP_TAIL_CALL;
+        }
+    }
+    return m;
+}
+
+// Longueur recopiable d’un mot appelé (sans son OP_END), ou -1 s’il ne peut pas être inliné :
+// trop long, sortie anticipée, ou opérande propre au mot (chaînes, constantes, nom).
+static long int inlineLength(CompiledWord *callee) {
+    const Instruction *src = callee->source ? callee->source : callee->code;
+    long int n = callee->source ? callee->source_length : callee->code_length;
+    if (!callee->name || callee->immediate || n <= 0) return -1;
+    int has_end = src[n - 1].opcode == OP_END;
+    if (has_end) n--;
+    if (n <= 0 || n > INLINE_MAX_SIZE) return -1;
+    for (long int i = 0; i < n; i++) {
+        switch (src[i].opcode) {
+            case OP_END: case OP_EXIT: case OP_SEE: case OP_CLEAR_STRINGS: case OP_PUSH_BIG: case OP_CASE_DISPATCH:
+            case OP_VARIABLE: case OP_CREATE: case OP_STRING: case OP_FORGET: case OP_LOAD:
+            case OP_IRC_SEND: case OP_DOT_QUOTE: case OP_QUOTE: case OP_LITSTRING:
+                return -1;
+            default:
+                break;
+        }
+        // Les sauts d’un builtin n’ont pas de cible ; ceux d’un mot ":" sont relogeables
+        if (isBranchOp(src[i].opcode) && (!has_end || src[i].operand < 0 || src[i].operand > n + 1)) return -1;
+    }
+    return n;
+}
+
+static void recordInlined(CompiledWord *word, long int callee) {
+    for (long int k = 0; k < word->inlined_count; k++) {
+        if (word->inlined[k] == callee) return;
+    }
+    long int *list = realloc(word->inlined, (word->inlined_count + 1) * sizeof(long int));
+    if (!list) return;
+    word->inlined = list;
+    word->inlined[word->inlined_count++] = callee;
+}
+
+// Code produit par expandInline, agrandi par doublement
+typedef struct {
+    Instruction *code;
+    long int length;
+    long int capacity;
+} CodeBuffer;
+
+// Recopie src[0..n) à la fin de out en remplaçant les OP_CALL vers de petits mots
+// par leur code. Les sauts de src sont renumérotés ; au-delà de depth 0, une cible n + 1
+// (l’OP_END retiré) devient la fin de la séquence recopiée. 0 si une allocation échoue.
+static int expandInline(CompiledWord *word, long int self, DynamicDictionary *dict,
+                        const Instruction *src, long int n, CodeBuffer *out, int depth) {
+    long int *map = malloc((n + 1) * sizeof(long int));
+    char *direct = calloc(n + 1, 1);
+    if (!map || !direct) {
+        free(map);
+        free(direct);
+        return 0;
+    }
+    for (long int i = 0; i < n; i++) {
+        map[i] = out->length;
+        if (src[i].opcode == OP_CALL && depth < INLINE_MAX_DEPTH && src[i].operand != self &&
+            src[i].operand >= 0 && src[i].operand < dict->count) {
+            CompiledWord *callee = dictWord(dict, src[i].operand);
+            long int len = inlineLength(callee);
+            if (len > 0) {
+                recordInlined(word, src[i].operand);
+                if (src[i].operand >= dict->base) callee->called = 1;
+                if (!expandInline(word, self, dict, callee->source ? callee->source : callee->code,
+                                  len, out, depth + 1)) {
+                    free(map);
+                    free(direct);
+                    return 0;
+                }
+                continue;
+            }
+        }
+        if (out->length >= out->capacity) {
+            long int capacity = out->capacity ? out->capacity * 2 : 64;
+            Instruction *code = realloc(out->code, capacity * sizeof(Instruction));
+            if (!code) {
+                free(map);
+                free(direct);
+                return 0;
+            }
+            out->code = code;
+            out->capacity = capacity;
+        }
+        direct[i] = 1;
+        out->code[out->length++] = src[i];
+    }
+    map[n] = out->length;
+    for (long int i = 0; i < n; i++) {
+        if (!direct[i] || !isBranchOp(src[i].opcode)) continue;
+        long int t = src[i].operand;
+        if (t >= 0 && t <= n) out->code[map[i]].operand = map[t];
+        else if (depth > 0 && t == n + 1) out->code[map[i]].operand = map[n];
+        else out->code[map[i]].operand = -1; // Cible invalide : VM_JUMP la refusera comme avant
+    }
+    free(map);
+    free(direct);
+    return 1;
+}
+
+// Effet d’une instruction sur la pile de données : cellules lues sous le sommet, cellules laissées.
+// 0 si l’effet dépend des valeurs ou de l’état à l’exécution (PICK, @, CLEAR-STACK, LOAD…).
+static int opStackEffect(OpCode op, long int *in, long int *out) {
+    switch (op) {
+        case OP_BEGIN: case OP_CASE: case OP_BRANCH: case OP_ENDOF: case OP_REPEAT: case OP_AGAIN:
+        case OP_LOOP: case OP_LEAVE: case OP_UNLOOP: case OP_END: case OP_EXIT:
+        case OP_CR: case OP_DOT_S: case OP_DOT_QUOTE: case OP_LITSTRING:
+            *in = 0; *out = 0; return 1;
+        case OP_PUSH: case OP_PUSH_BIG: case OP_I: case OP_J: case OP_I_ARRAY_FETCH:
+        case OP_DEPTH: case OP_CLOCK: case OP_FROM_R: case OP_R_FETCH:
+            *in = 0; *out = 1; return 1;
+        case OP_DROP: case OP_DOT: case OP_EMIT: case OP_NUM_TO_BIN: case OP_TO_R: case OP_THROW:
+        case OP_BRANCH_FALSE: case OP_WHILE: case OP_UNTIL: case OP_PLUS_LOOP: case OP_ENDCASE:
+            *in = 1; *out = 0; return 1;
+        case OP_NOT: case OP_BIT_NOT: case OP_SQRT: case OP_PRIME_TEST: case OP_SQUARE:
+        case OP_PUSH_ADD: case OP_PUSH_SUB: case OP_PUSH_MUL: case OP_CASE_DISPATCH:
+            *in = 1; *out = 1; return 1;
+        case OP_DUP: case OP_TOP:
+            *in = 1; *out = 2; return 1;
+        case OP_2DROP: case OP_DO: case OP_EQ_BRANCH_FALSE: case OP_LT_BRANCH_FALSE:
+            *in = 2; *out = 0; return 1;
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD:
+        case OP_EQ: case OP_LT: case OP_GT: case OP_AND: case OP_OR: case OP_XOR:
+        case OP_BIT_AND: case OP_BIT_OR: case OP_BIT_XOR: case OP_LSHIFT: case OP_RSHIFT:
+        case OP_NIP: case OP_OF: // OF garde le sélecteur sur ses deux chemins
+            *in = 2; *out = 1; return 1;
+        case OP_SWAP: case OP_OVER_ADD:
+            *in = 2; *out = 2; return 1;
+        case OP_OVER:
+            *in = 2; *out = 3; return 1;
+        case OP_ROT:
+            *in = 3; *out = 3; return 1;
+        default:
+            return 0;
+    }
+}
+
+// Vérifie l’effet d’un mot sur la pile de données par interprétation abstraite de son code
+// exécuté : chaque instruction atteinte l’est toujours à la même profondeur (IF/ELSE, boucles,
+// CASE) et toutes les sorties aussi ; un appel n’est admis que vers un autre mot vérifié.
+// Renvoie 1 si verified ou l’effet ont changé (les appelants sont alors à revérifier).
+static int verifyWord(CompiledWord *word, long int self, DynamicDictionary *dict) {
+    long int n = word->code_length;
+    long int *depth = malloc((n + 1) * sizeof(long int)); // Relative à l’entrée, LONG_MIN si non atteinte
+    long int *work = malloc((n + 1) * sizeof(long int));
+    long int work_top = 0, low = 0, high = 0, exit_depth = LONG_MIN;
+    int ok = depth && work && n > 0;
+    for (long int i = 0; i < n; i++) {
+        const Instruction *instr = &word->code[i];
+        if ((instr->opcode == OP_CALL || instr->opcode == OP_TAIL_CALL) &&
+            instr->operand >= dict->base && instr->operand < dict->count) {
+            dictWord(dict, instr->operand)->called = 1;
+        }
+    }
+    if (ok) {
+        for (long int i = 0; i <= n; i++) depth[i] = LONG_MIN;
+        depth[0] = 0;
+        work[work_top++] = 0;
+    }
+    while (ok && work_top > 0) {
+        long int ip = work[--work_top], d = depth[ip];
+        if (ip == n) { // Fin du code : sortie du mot
+            if (exit_depth == LONG_MIN) exit_depth = d;
+            else ok = exit_depth == d;
+            continue;
+        }
+        const Instruction *instr = &word->code[ip];
+        long int in, out;
+        if (instr->opcode == OP_CALL || instr->opcode == OP_TAIL_CALL) {
+            long int callee = instr->operand;
+            CompiledWord *target = (callee >= 0 && callee < dict->count && callee != self) ? dictWord(dict, callee) : NULL;
+            if (!target || !target->verified) {
+                ok = 0;
+                break;
+            }
+            in = target->stack_in;
+            out = target->stack_out;
+            if (d + target->stack_grow > high) high = d + target->stack_grow;
+        } else if (!opStackEffect(instr->opcode, &in, &out)) {
+            ok = 0;
+            break;
+        }
+        if (d - in < low) low = d - in;
+        d += out - in;
+        if (d > high) high = d;
+
+        long int next[2], next_count = 0;
+        switch (instr->opcode) {
+            case OP_END: case OP_EXIT: case OP_TAIL_CALL:
+                next[next_count++] = n;
+                break;
+            case OP_BRANCH: case OP_ENDOF: case OP_REPEAT: case OP_AGAIN: case OP_LEAVE:
+                next[next_count++] = instr->operand;
+                break;
+            case OP_CASE_DISPATCH: {
+                if (instr->operand < 0 || instr->operand >= word->case_table_count) {
+                    ok = 0;
+                    break;
+                }
+                const CaseTable *table = &word->case_tables[instr->operand];
+                for (long int k = 0; k <= table->count && ok; k++) {
+                    long int t = k < table->count ? table->targets[k] : table->default_target;
+                    if (t < 0 || t > n) ok = 0;
+                    else if (depth[t] == LONG_MIN) { depth[t] = d; work[work_top++] = t; }
+                    else ok = depth[t] == d;
+                }
+                break;
+            }
+            default:
+                next[next_count++] = ip + 1;
+                if (isBranchOp(instr->opcode)) next[next_count++] = instr->operand;
+                break;
+        }
+        for (long int k = 0; k < next_count && ok; k++) {
+            long int t = next[k];
+            if (t < 0 || t > n) ok = 0; // Cible invalide : VM_JUMP s’en charge, avec ses contrôles
+            else if (depth[t] == LONG_MIN) { depth[t] = d; work[work_top++] = t; }
+            else ok = depth[t] == d;
+        }
+    }
+    ok = ok && exit_depth != LONG_MIN;
+    free(depth);
+    free(work);
+
+    int was_verified = word->verified;
+    long int was_in = word->stack_in, was_out = word->stack_out, was_grow = word->stack_grow;
+    word->verified = ok;
+    word->stack_in = ok ? -low : 0;
+    word->stack_out = ok ? exit_depth - low : 0;
+    word->stack_grow = ok ? high : 0;
+    return was_verified != word->verified || was_in != word->stack_in ||
+           was_out != word->stack_out || was_grow != word->stack_grow;
+}
+
+// Le code du mot appelle-t-il un mot marqué, ou un mot oublié (index hors du dictionnaire) ?
+static int callsMarked(const CompiledWord *word, const DynamicDictionary *dict, const char *marked) {
+    for (long int i = 0; i < word->code_length; i++) {
+        if (word->code[i].opcode != OP_CALL && word->code[i].opcode != OP_TAIL_CALL) continue;
+        long int callee = word->code[i].operand;
+        if (callee < 0 || callee >= dict->count || (marked && marked[callee])) return 1;
+    }
+    return 0;
+}
+
+// Repli prudent : tout mot qui appelle un autre mot perd sa vérification
+static void unverifyCallers(DynamicDictionary *dict) {
+    for (long int i = dict->base; i < dict->count; i++) {
+        CompiledWord *w = dictWord(dict, i);
+        int calls = 0;
+        for (long int k = 0; k < w->code_length && !calls; k++) {
+            calls = w->code[k].opcode == OP_CALL || w->code[k].opcode == OP_TAIL_CALL;
+        }
+        if (w->verified && calls) {
+            w->verified = 0;
+            if (w->threaded) threadWord(w);
+        }
+    }
+}
+
+// Des mots ont changé d’effet (changed, indexé par mot ; NULL après FORGET) : revérifie leurs
+// appelants, puis les appelants de ceux-ci, jusqu’à stabilité. Un mot vérifié ne compte ainsi
+// jamais sur l’effet périmé d’un appelé. Sans point fixe (récursion mutuelle née d’une
+// redéfinition) ou sans mémoire : unverifyCallers.
+static void reverifyCallers(DynamicDictionary *dict, const char *changed) {
+    long int n = dict->count;
+    char *dirty = calloc(n + 1, 1), *next = calloc(n + 1, 1);
+    if (dirty && next) {
+        if (changed) memcpy(dirty, changed, n);
+        for (int round = 0; round < VERIFY_ROUNDS; round++) {
+            int any = 0;
+            for (long int i = dict->base; i < n; i++) {
+                CompiledWord *w = dictWord(dict, i);
+                if (!w->code || !callsMarked(w, dict, dirty)) continue;
+                int was_verified = w->verified;
+                if (verifyWord(w, i, dict)) {
+                    next[i] = 1;
+                    any = 1;
+                    if (was_verified != w->verified && w->threaded) threadWord(w);
+                }
+            }
+            if (!any) {
+                free(dirty);
+                free(next);
+                return;
+            }
+            char *swap = dirty;
+            dirty = next;
+            next = swap;
+            memset(next, 0, n + 1);
+        }
+    }
+    free(dirty);
+    free(next);
+    unverifyCallers(dict);
+}
+
+// Le mot idx a changé d’effet : revérifie ses appelants, s’il en a jamais eu
+static void reverifyCallersOf(DynamicDictionary *dict, long int idx) {
+    if (idx < dict->base || idx >= dict->count || !dictWord(dict, idx)->called) return;
+    char *changed = calloc(dict->count + 1, 1);
+    if (!changed) {
+        unverifyCallers(dict);
+        return;
+    }
+    changed[idx] = 1;
+    reverifyCallers(dict, changed);
+    free(changed);
+}
+
+// Construit le code exécuté d’un mot depuis son code compilé : inlining, peephole, vérification
+// de l’effet sur la pile, threading.
+// Rejoué par recompileDependents quand un mot inliné est redéfini. Le code exécuté est rangé
+// à sa taille exacte dans l’arène ; en cas d’échec d’allocation, le code courant est gardé.
+void finalizeWord(CompiledWord *word, long int self, DynamicDictionary *dict) {
+    const Instruction *src = word->source ? word->source : word->code;
+    long int n = word->source ? word->source_length : word->code_length;
+    CodeBuffer out = { NULL, 0, 0 };
+    CaseTable *old_tables = word->case_tables; // Servent au code courant tant qu’il n’est pas remplacé
+    long int old_table_count = word->case_table_count;
+
+    word->inlined_count = 0;
+    word->case_tables = NULL;
+    word->case_table_count = 0;
+    if (!expandInline(word, self, dict, src, n, &out, 0)) goto keep;
+    long int m = optimizeCode(word, out.code, out.length, dict);
+
+    int changed = (m != n);
+    for (long int i = 0; i < m && !changed; i++) {
+        changed = out.code[i].opcode != src[i].opcode || out.code[i].operand != src[i].operand;
+    }
+    if (changed && !word->source) {
+        word->source = malloc(n * sizeof(Instruction));
+        if (!word->source) goto keep; // On garde le code non optimisé
+        memcpy(word->source, word->code, n * sizeof(Instruction));
+        word->source_length = n;
+    }
+    if (m != word->code_length) {
+        Instruction *code = (Instruction *)arena_alloc(dict->arena, m * sizeof(Instruction));
+        if (!code) goto keep;
+        arena_free(dict->arena, word->code, word->code_length * sizeof(Instruction));
+        word->code = code;
+    }
+    memcpy(word->code, out.code, m * sizeof(Instruction));
+    word->code_length = m;
+    free(out.code);
+    if (!changed && word->source) {
+        free(word->source);
+        word->source = NULL;
+        word->source_length = 0;
+    }
+    CaseTable *tables = word->case_tables;
+    long int table_count = word->case_table_count;
+    word->case_tables = old_tables;
+    word->case_table_count = old_table_count;
+    freeCaseTables(word);
+    word->case_tables = tables;
+    word->case_table_count = table_count;
+    verifyWord(word, self, dict);
+    threadWord(word);
+    return;
+
+keep: // Le code courant reste en place avec ses tables
+    free(out.code);
+    freeCaseTables(word);
+    word->case_tables = old_tables;
+    word->case_table_count = old_table_count;
+    verifyWord(word, self, dict);
+    threadWord(word);
+}
+
+// Un mot vient d’être redéfini : recompiler ceux qui avaient recopié son code, puis revérifier
+// ceux qui l’appellent ou appellent un mot recompilé
+void recompileDependents(DynamicDictionary *dict, long int idx) {
+    char *changed = NULL;
+    int recompiled = 0;
+    if (idx < dict->base || idx >= dict->count || !dictWord(dict, idx)->called) return; // Ni appelé ni recopié
+    for (long int i = dict->base; i < dict->count; i++) {
+        CompiledWord *w = dictWord(dict, i);
+        for (long int k = 0; k < w->inlined_count; k++) {
+            if (w->inlined[k] == idx) {
+                finalizeWord(w, i, dict);
+                if (!recompiled++) changed = calloc(dict->count + 1, 1);
+                if (changed) changed[i] = 1;
+                break;
+            }
+        }
+    }
+    if (!recompiled) {
+        reverifyCallersOf(dict, idx);
+        return;
+    }
+    if (!changed) {
+        unverifyCallers(dict);
+        return;
+    }
+    changed[idx] = 1;
+    reverifyCallers(dict, changed);
+    free(changed);
+}
+
+// Ajoute un grand littéral au pool du mot et renvoie son index
+long int addWordConstant(CompiledWord *word, mpz_t value) {
+    mpz_t *new_constants = realloc(word->constants, (word->constant_count + 1) * sizeof(mpz_t));
+    if (!new_constants) return -1;
+    word->constants = new_constants;
+    mpz_init_set(word->constants[word->constant_count], value);
+    return word->constant_count++;
 }
  
 void send_to_channel(const char *msg) {
@@ -237,16 +1473,27 @@ void initEnv(Env *env, const char *nick) {
     strncpy(env->nick, nick, MAX_STRING_SIZE - 1);
     env->nick[MAX_STRING_SIZE - 1] = '\0';
 
-    env->main_stack.top = -1;
-    env->return_stack.top = -1;
-    for (int i = 0; i < STACK_SIZE; i++) {
-        mpz_init(env->main_stack.data[i]);
-        mpz_init(env->return_stack.data[i]);
-    }
-
-    initDynamicDictionary(&env->dictionary);
+    // Rien n’est alloué avant le premier empilement
+    Stack empty = { NULL, -1, 0, STACK_SIZE };
+    env->main_stack = empty;
+    env->return_stack = empty;
+    env->loop_stack = NULL;
+    env->loop_stack_top = 0;
+    env->loop_capacity = 0;
+
+    arena_init(&env->arena);
+    env->gmp = (GmpAccount *)malloc(sizeof(GmpAccount));
+    if (!env->gmp) {
+        send_to_channel("Erreur : Échec de l’allocation du compte mémoire");
+        exit(1);
+    }
+    env->gmp->live_bytes = 0;
+    env->gmp->quota = GMP_QUOTA_BYTES;
+    env->gmp->refs = 1;
+    initDynamicDictionary(&env->dictionary, builtinDictionary(), &env->arena);
 
     memory_init(&env->memory_list);
+    env->memory_list.arena = &env->arena;
 
     // Ajout de la variable USERNAME
     unsigned long username_idx = memory_create(&env->memory_list, "USERNAME", TYPE_STRING);
@@ -259,32 +1506,60 @@ void initEnv(Env *env, const char *nick) {
                 resizeDynamicDictionary(&env->dictionary);
             }
             int dict_idx = env->dictionary.count++;
-            env->dictionary.words[dict_idx].name = strdup("USERNAME");
-            env->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-            env->dictionary.words[dict_idx].code[0].operand = username_idx;
-            env->dictionary.words[dict_idx].code_length = 1;
-            env->dictionary.words[dict_idx].string_count = 0;
-            env->dictionary.words[dict_idx].immediate = 0;
+            dictWord(&env->dictionary, dict_idx)->name = arena_strdup(&env->arena, "USERNAME");
+            dictIndexAdd(&env->dictionary, dict_idx);
+            setWordInstruction(&env->dictionary, dictWord(&env->dictionary, dict_idx), OP_PUSH, username_idx);
+            dictWord(&env->dictionary, dict_idx)->string_count = 0;
+            dictWord(&env->dictionary, dict_idx)->immediate = 0;
         }
     }
 
     env->buffer_pos = 0;
     memset(env->output_buffer, 0, BUFFER_SIZE);
     env->currentWord.name = NULL;
+    env->currentWord.code = NULL; // Tableaux alloués à la première définition
     env->currentWord.code_length = 0;
+    env->currentWord.strings = NULL;
     env->currentWord.string_count = 0;
+    env->code_capacity = 0;
+    env->string_capacity_word = 0;
+    env->currentWord.constants = NULL;
+    env->currentWord.constant_count = 0;
+    env->currentWord.threaded = NULL;
+    env->currentWord.source = NULL;
+    env->currentWord.source_length = 0;
+    env->currentWord.inlined = NULL;
+    env->currentWord.inlined_count = 0;
+    env->currentWord.case_tables = NULL;
+    env->currentWord.case_table_count = 0;
+    env->currentWord.unchecked = NULL;
+    env->currentWord.verified = 0;
+    env->currentWord.immediate = 0;
     env->compiling = 0;
     env->current_word_index = -1;
 
     env->control_stack_top = 0;
 
-    env->string_stack_top = -1;
-    for (int i = 0; i < STACK_SIZE; i++) env->string_stack[i] = NULL;
+    env->string_slots = NULL;
+    env->string_slots_used = 0;
+    env->string_capacity = 0;
+    env->string_free_head = -1;
 
     env->error_flag = 0;
     env->emit_buffer[0] = '\0';
     env->emit_buffer_pos = 0;
 
+    env->frames = NULL;
+    env->frame_top = 0;
+    env->frame_capacity = 0;
+
+    env->abort_point = NULL;
+    env->catches = NULL;
+    env->catch_top = 0;
+    env->catch_capacity = 0;
+    env->catch_base = 0;
+    env->throw_code = 0;
+
     env->next = NULL;
 }
  
@@ -313,33 +1588,36 @@ void freeEnv(const char *nick) {
 
     if (curr == currentenv) currentenv = NULL;
 
-    for (int i = 0; i < STACK_SIZE; i++) {
-        mpz_clear(curr->main_stack.data[i]);
-        mpz_clear(curr->return_stack.data[i]);
+    for (long int i = 0; i < curr->main_stack.capacity; i++) cell_clear(&curr->main_stack.data[i]);
+    for (long int i = 0; i < curr->return_stack.capacity; i++) cell_clear(&curr->return_stack.data[i]);
+    for (int i = 0; i < curr->loop_capacity; i++) {
+        cell_clear(&curr->loop_stack[i].index);
+        cell_clear(&curr->loop_stack[i].limit);
     }
+    free(curr->main_stack.data);
+    free(curr->return_stack.data);
+    free(curr->loop_stack);
 
-    for (long int i = 0; i < curr->dictionary.count; i++) {
-        if (curr->dictionary.words[i].name) free(curr->dictionary.words[i].name);
-        for (int j = 0; j < curr->dictionary.words[i].string_count; j++) {
-            if (curr->dictionary.words[i].strings[j]) free(curr->dictionary.words[i].strings[j]);
-        }
+    // En-têtes, noms, code et chaînes compilées sont dans l’arène, rendue en bloc plus bas
+    for (long int i = curr->dictionary.base; i < curr->dictionary.count; i++) {
+        freeWordCode(dictWord(&curr->dictionary, i));
     }
-    free(curr->dictionary.words); // Libérer le tableau dynamique
+    free(curr->dictionary.words); // Libérer le tableau des pointeurs d’en-têtes
+    free(curr->dictionary.index);
 
-    MemoryNode *node = curr->memory_list.head;
-    while (node) {
-        MemoryNode *next = node->next;
-        memory_free(&curr->memory_list, node->name);
-        node = next;
-    }
+    memory_destroy(&curr->memory_list);
 
-    if (curr->currentWord.name) free(curr->currentWord.name);
-    for (int i = 0; i < curr->currentWord.string_count; i++) {
-        if (curr->currentWord.strings[i]) free(curr->currentWord.strings[i]);
-    }
-    for (int i = 0; i <= curr->string_stack_top; i++) {
-        if (curr->string_stack[i]) free(curr->string_stack[i]);
+    freeWordCode(&curr->currentWord);
+    free(curr->currentWord.code);
+    free(curr->currentWord.strings);
+    for (int i = 0; i < curr->string_slots_used; i++) {
+        if (curr->string_slots[i].used) fstr_release(&curr->arena, curr->string_slots[i].str);
     }
+    free(curr->string_slots);
+    free(curr->frames);
+    free(curr->catches);
+    gmp_account_release(curr->gmp);
+    arena_destroy(&curr->arena);
     free(curr);
 }
 Env *findEnv(const char *nick) {
@@ -733,136 +2011,313 @@ char *generate_image_tiny(const char *prompt) {
     return short_url;
 }
 // Fonctions Forth
-void push(Stack *stack, mpz_t value) {
-    if (stack->top < STACK_SIZE - 1) {
-        mpz_set(stack->data[++stack->top], value);
-    } else {
-        if (currentenv) currentenv->error_flag = 1;
-        send_to_channel("Error: Stack overflow");
-    }
+// Renvoie la cellule à remplir au sommet, NULL en cas de débordement
+// Assure la place pour need cellules ; 0 au-delà de la limite ou si l’allocation échoue
+static int stack_reserve(Stack *stack, long int need) {
+    if (need <= stack->capacity) return 1;
+    if (need > stack->limit) return 0;
+    long int cap = stack->capacity ? stack->capacity * 2 : STACK_INITIAL;
+    while (cap < need) cap *= 2;
+    if (cap > stack->limit) cap = stack->limit;
+    Cell *data = realloc(stack->data, cap * sizeof(Cell));
+    if (!data) return 0;
+    for (long int i = stack->capacity; i < cap; i++) cell_init(&data[i]);
+    stack->data = data;
+    stack->capacity = cap;
+    return 1;
+}
+
+// Nouvelle limite ; les cellules allouées au-delà (toutes vides) sont rendues
+static void stack_set_limit(Stack *stack, long int limit) {
+    stack->limit = limit;
+    if (stack->capacity <= limit) return;
+    for (long int i = limit; i < stack->capacity; i++) cell_clear(&stack->data[i]);
+    Cell *data = realloc(stack->data, limit * sizeof(Cell));
+    if (data) stack->data = data;
+    stack->capacity = limit;
+}
+
+static inline Cell *push_slot(Stack *stack) {
+    if (stack->top + 1 < stack->capacity || stack_reserve(stack, stack->top + 2)) return &stack->data[++stack->top];
+    forth_throw(THROW_STACK_OVERFLOW, "Stack overflow");
+    return NULL;
+}
+
+void push(Stack *stack, const Cell *value) {
+    // value peut être une cellule de la pile (DUP, OVER…) que l’agrandissement déplace
+    long int at = (stack->capacity && value >= stack->data && value < stack->data + stack->capacity)
+                  ? value - stack->data : -1;
+    Cell *slot = push_slot(stack);
+    if (slot) cell_set(slot, at >= 0 ? &stack->data[at] : value);
 }
 
-void pop(Stack *stack, mpz_t result) {
+void push_si(Stack *stack, long int value) {
+    Cell *slot = push_slot(stack);
+    if (slot) cell_set_si(slot, value);
+}
+
+void push_mpz(Stack *stack, mpz_srcptr value) {
+    Cell *slot = push_slot(stack);
+    if (slot) cell_set_mpz(slot, value);
+}
+
+void pop(Stack *stack, Cell *result) {
     if (stack->top >= 0) {
-        mpz_set(result, stack->data[stack->top--]);
+        cell_set(result, &stack->data[stack->top--]);
     } else {
-        if (currentenv) currentenv->error_flag = 1;
-        send_to_channel("Error: Stack underflow");
-        mpz_set_ui(result, 0);
+        cell_set_si(result, 0); // Hors VM, l’appelant continue avec 0
+        forth_throw(THROW_STACK_UNDERFLOW, "Stack underflow");
     }
 }
 
-void push_string(char *str) {
-    if (!currentenv) return;
-    if (currentenv->string_stack_top < STACK_SIZE - 1) {
-        currentenv->string_stack[++currentenv->string_stack_top] = str;
-    } else {
-        currentenv->error_flag = 1;
-        send_to_channel("Error: String stack overflow");
+// forth_throw pour la VM, où abort_point est toujours armé : ne revient jamais, les handlers
+// n’ont donc rien à faire après l’erreur
+static void vm_throw(long int code, const char *msg) __attribute__((noreturn));
+static void vm_throw(long int code, const char *msg) {
+    forth_throw(code, msg);
+    abort(); // Pas de point de reprise : executeCompiledWord l’arme avant tout handler
+}
+
+// Opérateur lu en place avec trop peu de cellules (VM seulement) : la pile reste telle quelle
+static void stack_underflow(void) __attribute__((noreturn));
+static void stack_underflow(void) {
+    vm_throw(THROW_STACK_UNDERFLOW, "Stack underflow");
+}
+
+// Quota GMP dépassé pendant un calcul (flag_error dans l’allocateur) : l’erreur part dès que
+// GMP a rendu la main, avant que l’instruction suivante ne fasse grossir le nombre encore
+static inline void gmp_quota_check(void) {
+    if (currentenv && currentenv->error_flag) forth_throw(currentenv->throw_code, NULL);
+}
+
+// Arithmétique sur cellules : calcul natif tant qu'il ne déborde pas, GMP sinon.
+// r peut être l'un des opérandes.
+static inline void cell_add(Cell *r, const Cell *x, const Cell *y) {
+    long int v;
+    if (x->tag == CELL_SMALL && y->tag == CELL_SMALL && !__builtin_add_overflow(x->small, y->small, &v)) {
+        cell_set_si(r, v);
+        return;
     }
+    mpz_srcptr zx = cell_mpz(x, mpz_pool[0]), zy = cell_mpz(y, mpz_pool[1]);
+    cell_ensure_z(r);
+    mpz_add(r->z, zx, zy);
+    r->tag = CELL_BIG;
+    cell_normalize(r);
+    gmp_quota_check();
 }
 
-char *pop_string() {
-    if (!currentenv) return NULL;
-    if (currentenv->string_stack_top >= 0) {
-        return currentenv->string_stack[currentenv->string_stack_top--];
-    } else {
-        currentenv->error_flag = 1;
-        send_to_channel("Error: String stack underflow");
-        return NULL;
+// Tableau désigné par un handle de CREATE sur la pile, NULL sinon
+static MemoryNode *array_from_cell(const Cell *c) {
+    if (c->tag != CELL_SMALL || memory_get_type((unsigned long)c->small) != TYPE_ARRAY) return NULL;
+    MemoryNode *node = memory_get(&currentenv->memory_list, (unsigned long)c->small);
+    return node && node->type == TYPE_ARRAY ? node : NULL;
+}
+
+// Élément i (< size) d’un tableau += v, en restant compact tant que la somme tient dans un long
+static int array_add(MemoryNode *node, unsigned long i, const Cell *v) {
+    long int *packed = node->value.array.packed, sum;
+    if (packed && v->tag == CELL_SMALL && !__builtin_add_overflow(packed[i], v->small, &sum)) {
+        packed[i] = sum;
+        return 1;
     }
+    if (!memory_array_promote(node)) return 0;
+    cell_add(&node->value.array.data[i], &node->value.array.data[i], v);
+    return 1;
 }
 
-void set_error(const char *msg) {
-    if (!currentenv) return;
-    char err_msg[512];
-    snprintf(err_msg, sizeof(err_msg), "Error: %s", msg);
-    send_to_channel(err_msg);
-    currentenv->error_flag = 1;
-    // Nettoyer return_stack si utilisé dans une boucle
-    while (currentenv->return_stack.top >= 2 && currentenv->return_stack.top % 3 == 0) {
-        currentenv->return_stack.top -= 3; // Dépile limit, index, addr
+static inline void cell_sub(Cell *r, const Cell *x, const Cell *y) {
+    long int v;
+    if (x->tag == CELL_SMALL && y->tag == CELL_SMALL && !__builtin_sub_overflow(x->small, y->small, &v)) {
+        cell_set_si(r, v);
+        return;
     }
+    mpz_srcptr zx = cell_mpz(x, mpz_pool[0]), zy = cell_mpz(y, mpz_pool[1]);
+    cell_ensure_z(r);
+    mpz_sub(r->z, zx, zy);
+    r->tag = CELL_BIG;
+    cell_normalize(r);
+    gmp_quota_check();
 }
 
-int findCompiledWordIndex(char *name) {
-    if (!currentenv) return -1;
-    for (long int i = 0; i < currentenv->dictionary.count; i++) {
-        if (currentenv->dictionary.words[i].name && strcmp(currentenv->dictionary.words[i].name, name) == 0) return i;
+static inline void cell_mul(Cell *r, const Cell *x, const Cell *y) {
+    long int v;
+    if (x->tag == CELL_SMALL && y->tag == CELL_SMALL && !__builtin_mul_overflow(x->small, y->small, &v)) {
+        cell_set_si(r, v);
+        return;
     }
-    return -1;
+    mpz_srcptr zx = cell_mpz(x, mpz_pool[0]), zy = cell_mpz(y, mpz_pool[1]);
+    cell_ensure_z(r);
+    mpz_mul(r->z, zx, zy);
+    r->tag = CELL_BIG;
+    cell_normalize(r);
+    gmp_quota_check();
 }
 
+// Quotient arrondi vers -inf (mpz_fdiv_q) ; y non nul
+static inline void cell_div(Cell *r, const Cell *x, const Cell *y) {
+    if (x->tag == CELL_SMALL && y->tag == CELL_SMALL && !(x->small == LONG_MIN && y->small == -1)) {
+        long int q = x->small / y->small;
+        if ((x->small % y->small != 0) && ((x->small < 0) != (y->small < 0))) q--;
+        cell_set_si(r, q);
+        return;
+    }
+    mpz_srcptr zx = cell_mpz(x, mpz_pool[0]), zy = cell_mpz(y, mpz_pool[1]);
+    cell_ensure_z(r);
+    mpz_fdiv_q(r->z, zx, zy);
+    r->tag = CELL_BIG;
+    cell_normalize(r);
+}
 
-void print_word_definition_irc(int index, Stack *stack) {
-    if (!currentenv || index < 0 || index >= currentenv->dictionary.count) {
-        send_to_channel("SEE: Unknown word");
+// Reste toujours positif (mpz_mod) ; y non nul
+static inline void cell_mod(Cell *r, const Cell *x, const Cell *y) {
+    if (x->tag == CELL_SMALL && y->tag == CELL_SMALL && y->small != LONG_MIN) {
+        long int m = (y->small == -1) ? 0 : x->small % y->small;
+        if (m < 0) m += y->small < 0 ? -y->small : y->small;
+        cell_set_si(r, m);
         return;
     }
+    mpz_srcptr zx = cell_mpz(x, mpz_pool[0]), zy = cell_mpz(y, mpz_pool[1]);
+    cell_ensure_z(r);
+    mpz_mod(r->z, zx, zy);
+    r->tag = CELL_BIG;
+    cell_normalize(r);
+}
+
+// Double la table de slots de chaînes, dans la limite de la pile de données
+static int string_slots_grow(Env *env) {
+    long int cap = env->string_capacity ? env->string_capacity * 2L : STACK_INITIAL;
+    if (cap > env->main_stack.limit) cap = env->main_stack.limit;
+    if (cap <= env->string_capacity) return 0;
+    StringSlot *slots = realloc(env->string_slots, cap * sizeof(StringSlot));
+    if (!slots) return 0;
+    for (long int i = env->string_capacity; i < cap; i++) {
+        slots[i].str = NULL;
+        slots[i].gen = 0;
+        slots[i].used = 0;
+    }
+    env->string_slots = slots;
+    env->string_capacity = (int)cap;
+    return 1;
+}
+
+// Prend la référence str et renvoie son handle, -1 si tous les slots sont pris
+long int push_string(char *str) {
+    if (!currentenv) return -1;
+    Env *env = currentenv;
+    int slot;
+    if (env->string_free_head >= 0) {
+        slot = env->string_free_head;
+        env->string_free_head = env->string_slots[slot].next_free;
+    } else if (env->string_slots_used < env->string_capacity || string_slots_grow(env)) {
+        slot = env->string_slots_used++;
+    } else {
+        fstr_release(&env->arena, str);
+        set_error("String stack overflow");
+        return -1;
+    }
+    env->string_slots[slot].str = str;
+    env->string_slots[slot].used = 1;
+    return (env->string_slots[slot].gen << STRING_SLOT_BITS) | slot;
+}
+
+// Range la chaîne et dépose son handle sur stack
+static void push_string_handle(Stack *stack, char *str) {
+    long int handle = push_string(str);
+    if (handle >= 0) push_si(stack, handle);
+}
+
+// Slot désigné par un handle, NULL si le handle est invalide ou périmé
+static StringSlot *string_slot(const Cell *handle) {
+    if (handle->tag != CELL_SMALL || handle->small < 0) return NULL;
+    long int slot = handle->small & STRING_SLOT_MASK;
+    if (slot >= currentenv->string_slots_used) return NULL;
+    StringSlot *s = &currentenv->string_slots[slot];
+    if (!s->used || s->gen != (handle->small >> STRING_SLOT_BITS)) return NULL;
+    return s;
+}
+
+// Rend le slot en O(1) ; la référence qu'il portait passe à l'appelant
+static char *take_string(StringSlot *s) {
+    char *str = s->str;
+    s->str = NULL;
+    s->used = 0;
+    s->gen++;
+    s->next_free = currentenv->string_free_head;
+    currentenv->string_free_head = (int)(s - currentenv->string_slots);
+    return str;
+}
+
+// Note une erreur sans dérouter : message (sauf si un CATCH de l’exécution en cours l’attend),
+// error_flag et code pour CATCH. msg NULL : message déjà envoyé.
+static void flag_error(long int code, const char *msg) {
+    if (!currentenv) return;
+    if (msg && currentenv->catch_top <= currentenv->catch_base) {
+        char err_msg[sizeof("Error: ") + 512]; // Les messages sont construits dans des tampons de 512
+        snprintf(err_msg, sizeof(err_msg), "Error: %s", msg);
+        send_to_channel(err_msg);
+    }
+    currentenv->error_flag = 1;
+    currentenv->throw_code = code;
+}
+
+// Erreur Forth : dans la VM, retour direct au point de reprise de executeCompiledWord (CATCH
+// ou abandon du mot) ; hors VM (compilation), l’appelant continue et error_flag arrête la ligne.
+void forth_throw(long int code, const char *msg) {
+    flag_error(code, msg);
+    if (currentenv && currentenv->abort_point) longjmp(*currentenv->abort_point, 1);
+}
+
+void set_error(const char *msg) {
+    forth_throw(THROW_ABORT, msg);
+}
 
-    CompiledWord *word = &currentenv->dictionary.words[index];
+int findCompiledWordIndex(char *name) {
+    if (!currentenv) return -1;
+    return dictLookup(&currentenv->dictionary, name);
+}
+
+
+// Affiche une séquence d’instructions du mot, précédée de prefix
+static void print_code_irc(CompiledWord *word, const Instruction *code, long int code_length, const char *prefix) {
     char def_msg[512] = "";
-    snprintf(def_msg, sizeof(def_msg), ": %s ", word->name);
+    snprintf(def_msg, sizeof(def_msg), "%s", prefix);
 
     // Tableau pour suivre les cibles des branchements (IF, OF, etc.)
-    long int branch_targets[WORD_CODE_SIZE];
+    long int *branch_targets = malloc((code_length + 1) * sizeof(long int));
     int branch_depth = 0;
+    if (!branch_targets) return;
     int has_semicolon = 0;
 
-    for (long int i = 0; i < word->code_length; i++) {
-        Instruction instr = word->code[i];
+    if (!primitives_ready) initPrimitives();
+
+    for (long int i = 0; i < code_length; i++) {
+        Instruction instr = code[i];
         char instr_str[64] = "";
 
         switch (instr.opcode) {
             case OP_PUSH:
-                if (instr.operand < word->string_count && word->strings[instr.operand]) {
-                    snprintf(instr_str, sizeof(instr_str), "%s ", word->strings[instr.operand]);
+                snprintf(instr_str, sizeof(instr_str), "%ld ", instr.operand);
+                break;
+            case OP_PUSH_BIG:
+                if (instr.operand >= 0 && instr.operand < word->constant_count) {
+                    char *num_str = mpz_get_str_alloc(10, word->constants[instr.operand]);
+                    if (strlen(num_str) < sizeof(instr_str) - 1) {
+                        snprintf(instr_str, sizeof(instr_str), "%s ", num_str);
+                    } else {
+                        snprintf(instr_str, sizeof(instr_str), "(%zu digits) ", strlen(num_str));
+                    }
+                    free(num_str);
                 } else {
-                    snprintf(instr_str, sizeof(instr_str), "%ld ", instr.operand);
+                    snprintf(instr_str, sizeof(instr_str), "(PUSH_BIG %ld) ", instr.operand);
                 }
                 break;
             case OP_CALL:
-                if (instr.operand < currentenv->dictionary.count && currentenv->dictionary.words[instr.operand].name) {
-                    snprintf(instr_str, sizeof(instr_str), "%s ", currentenv->dictionary.words[instr.operand].name);
+                if (instr.operand < currentenv->dictionary.count && dictWord(&currentenv->dictionary, instr.operand)->name) {
+                    snprintf(instr_str, sizeof(instr_str), "%s ", dictWord(&currentenv->dictionary, instr.operand)->name);
                 } else {
                     snprintf(instr_str, sizeof(instr_str), "(CALL %ld) ", instr.operand);
                 }
                 break;
-            case OP_ADD: snprintf(instr_str, sizeof(instr_str), "+ "); break;
-            case OP_SUB: snprintf(instr_str, sizeof(instr_str), "- "); break;
-            case OP_MUL: snprintf(instr_str, sizeof(instr_str), "* "); break;
-            case OP_DIV: snprintf(instr_str, sizeof(instr_str), "/ "); break;
-            case OP_MOD: snprintf(instr_str, sizeof(instr_str), "MOD "); break;
-            case OP_DUP: snprintf(instr_str, sizeof(instr_str), "DUP "); break;
-            case OP_DROP: snprintf(instr_str, sizeof(instr_str), "DROP "); break;
-            case OP_SWAP: snprintf(instr_str, sizeof(instr_str), "SWAP "); break;
-            case OP_OVER: snprintf(instr_str, sizeof(instr_str), "OVER "); break;
-            case OP_ROT: snprintf(instr_str, sizeof(instr_str), "ROT "); break;
-            case OP_TO_R: snprintf(instr_str, sizeof(instr_str), ">R "); break;
-            case OP_FROM_R: snprintf(instr_str, sizeof(instr_str), "R> "); break;
-            case OP_R_FETCH: snprintf(instr_str, sizeof(instr_str), "R@ "); break;
-            case OP_EQ: snprintf(instr_str, sizeof(instr_str), "= "); break;
-            case OP_LT: snprintf(instr_str, sizeof(instr_str), "< "); break;
-            case OP_GT: snprintf(instr_str, sizeof(instr_str), "> "); break;
-            case OP_AND: snprintf(instr_str, sizeof(instr_str), "AND "); break;
-            case OP_OR: snprintf(instr_str, sizeof(instr_str), "OR "); break;
-            case OP_NOT: snprintf(instr_str, sizeof(instr_str), "NOT "); break;
-            case OP_XOR: snprintf(instr_str, sizeof(instr_str), "XOR "); break;
-            case OP_BIT_AND: snprintf(instr_str, sizeof(instr_str), "& "); break;
-            case OP_BIT_OR: snprintf(instr_str, sizeof(instr_str), "| "); break;
-            case OP_BIT_XOR: snprintf(instr_str, sizeof(instr_str), "^ "); break;
-            case OP_BIT_NOT: snprintf(instr_str, sizeof(instr_str), "~ "); break;
-            case OP_LSHIFT: snprintf(instr_str, sizeof(instr_str), "<< "); break;
-            case OP_RSHIFT: snprintf(instr_str, sizeof(instr_str), ">> "); break;
-            case OP_CR: snprintf(instr_str, sizeof(instr_str), "CR "); break;
-            case OP_EMIT: snprintf(instr_str, sizeof(instr_str), "EMIT "); break;
-            case OP_DOT: snprintf(instr_str, sizeof(instr_str), ". "); break;
-            case OP_DOT_S: snprintf(instr_str, sizeof(instr_str), ".S "); break;
-            case OP_FETCH: snprintf(instr_str, sizeof(instr_str), "@ "); break;
-            case OP_STORE: snprintf(instr_str, sizeof(instr_str), "! "); break;
-            case OP_PLUSSTORE: snprintf(instr_str, sizeof(instr_str), "+! "); break;
-            case OP_I: snprintf(instr_str, sizeof(instr_str), "I "); break;
-            case OP_J: snprintf(instr_str, sizeof(instr_str), "J "); break;
             case OP_DO:
                 snprintf(instr_str, sizeof(instr_str), "DO ");
                 branch_targets[branch_depth++] = instr.operand;
@@ -875,7 +2330,6 @@ void print_word_definition_irc(int index, Stack *stack) {
                 snprintf(instr_str, sizeof(instr_str), "+LOOP ");
                 if (branch_depth > 0) branch_depth--;
                 break;
-            case OP_UNLOOP: snprintf(instr_str, sizeof(instr_str), "UNLOOP "); break;
             case OP_BRANCH:
                 snprintf(instr_str, sizeof(instr_str), "BRANCH(%ld) ", instr.operand);
                 branch_targets[branch_depth++] = instr.operand;
@@ -888,6 +2342,14 @@ void print_word_definition_irc(int index, Stack *stack) {
                 snprintf(instr_str, sizeof(instr_str), "CASE ");
                 branch_targets[branch_depth++] = i; // Marquer le début du CASE
                 break;
+            case OP_CASE_DISPATCH:
+                if (instr.operand >= 0 && instr.operand < word->case_table_count) {
+                    snprintf(instr_str, sizeof(instr_str), word->case_tables[instr.operand].keys ? "[CASE search] " : "[CASE jump] ");
+                } else {
+                    snprintf(instr_str, sizeof(instr_str), "(CASE_DISPATCH %ld) ", instr.operand);
+                }
+                branch_targets[branch_depth++] = i;
+                break;
             case OP_OF:
                 snprintf(instr_str, sizeof(instr_str), "OF ");
                 branch_targets[branch_depth++] = instr.operand;
@@ -912,11 +2374,11 @@ void print_word_definition_irc(int index, Stack *stack) {
                 if (branch_depth > 0 && i + 1 == branch_targets[branch_depth - 1]) {
                     snprintf(instr_str, sizeof(instr_str), "THEN ");
                     branch_depth--;
-                    if (i + 1 == word->code_length) {
+                    if (i + 1 == code_length) {
                         strncat(instr_str, ";", sizeof(instr_str) - strlen(instr_str) - 1);
                         has_semicolon = 1;
                     }
-                } else if (i + 1 == word->code_length) {
+                } else if (i + 1 == code_length) {
                     snprintf(instr_str, sizeof(instr_str), "; ");
                     has_semicolon = 1;
                 }
@@ -956,9 +2418,6 @@ void print_word_definition_irc(int index, Stack *stack) {
                     snprintf(instr_str, sizeof(instr_str), "\"(invalid) ");
                 }
                 break;
-            case OP_PRINT: snprintf(instr_str, sizeof(instr_str), "PRINT "); break;
-            case OP_NUM_TO_BIN: snprintf(instr_str, sizeof(instr_str), "NUM-TO-BIN "); break;
-            case OP_PRIME_TEST: snprintf(instr_str, sizeof(instr_str), "PRIME? "); break;
             case OP_BEGIN:
                 snprintf(instr_str, sizeof(instr_str), "BEGIN ");
                 branch_targets[branch_depth++] = i;
@@ -979,8 +2438,6 @@ void print_word_definition_irc(int index, Stack *stack) {
                 snprintf(instr_str, sizeof(instr_str), "AGAIN ");
                 if (branch_depth > 0) branch_depth--;
                 break;
-            case OP_EXIT: snprintf(instr_str, sizeof(instr_str), "EXIT "); break;
-            case OP_WORDS: snprintf(instr_str, sizeof(instr_str), "WORDS "); break;
             case OP_FORGET:
                 if (instr.operand < word->string_count && word->strings[instr.operand]) {
                     snprintf(instr_str, sizeof(instr_str), "FORGET %s ", word->strings[instr.operand]);
@@ -995,7 +2452,6 @@ void print_word_definition_irc(int index, Stack *stack) {
                     snprintf(instr_str, sizeof(instr_str), "LOAD(invalid) ");
                 }
                 break;
-            case OP_ALLOT: snprintf(instr_str, sizeof(instr_str), "ALLOT "); break;
             case OP_CREATE:
                 if (instr.operand < word->string_count && word->strings[instr.operand]) {
                     snprintf(instr_str, sizeof(instr_str), "CREATE %s ", word->strings[instr.operand]);
@@ -1011,20 +2467,45 @@ void print_word_definition_irc(int index, Stack *stack) {
                     snprintf(instr_str, sizeof(instr_str), "IRC-SEND(invalid) ");
                 }
                 break;
-            case OP_SQRT: snprintf(instr_str, sizeof(instr_str), "SQRT "); break;
-            case OP_PICK: snprintf(instr_str, sizeof(instr_str), "PICK "); break;
             case OP_ROLL: snprintf(instr_str, sizeof(instr_str), "ROLL "); break;
             case OP_DEPTH: snprintf(instr_str, sizeof(instr_str), "DEPTH "); break;
             case OP_TOP: snprintf(instr_str, sizeof(instr_str), "TOP "); break;
             case OP_NIP: snprintf(instr_str, sizeof(instr_str), "NIP "); break;
-            case OP_CLEAR_STACK: snprintf(instr_str, sizeof(instr_str), "CLEAR-STACK "); break;
-            case OP_CLOCK: snprintf(instr_str, sizeof(instr_str), "CLOCK "); break;
             case OP_SEE:
                 snprintf(instr_str, sizeof(instr_str), "SEE ");
                 break;
-            case OP_2DROP: snprintf(instr_str, sizeof(instr_str), "2DROP "); break;
+            case OP_SQUARE: snprintf(instr_str, sizeof(instr_str), "[DUP *] "); break;
+            case OP_OVER_ADD: snprintf(instr_str, sizeof(instr_str), "[OVER +] "); break;
+            case OP_PUSH_ADD: snprintf(instr_str, sizeof(instr_str), "[%ld +] ", instr.operand); break;
+            case OP_PUSH_SUB: snprintf(instr_str, sizeof(instr_str), "[%ld -] ", instr.operand); break;
+            case OP_PUSH_MUL: snprintf(instr_str, sizeof(instr_str), "[%ld *] ", instr.operand); break;
+            case OP_EQ_BRANCH_FALSE:
+                snprintf(instr_str, sizeof(instr_str), "[= IF] ");
+                branch_targets[branch_depth++] = instr.operand;
+                break;
+            case OP_LT_BRANCH_FALSE:
+                snprintf(instr_str, sizeof(instr_str), "[< IF] ");
+                branch_targets[branch_depth++] = instr.operand;
+                break;
+            case OP_I_ARRAY_FETCH: {
+                MemoryNode *node = memory_get(&currentenv->memory_list, instr.operand);
+                snprintf(instr_str, sizeof(instr_str), "[I %s @] ", node && node->name ? node->name : "?");
+                break;
+            }
+            case OP_TAIL_CALL:
+                if (instr.operand >= 0 && instr.operand < currentenv->dictionary.count && dictWord(&currentenv->dictionary, instr.operand)->name) {
+                    snprintf(instr_str, sizeof(instr_str), "[TAIL %s] ", dictWord(&currentenv->dictionary, instr.operand)->name);
+                } else {
+                    snprintf(instr_str, sizeof(instr_str), "(TAIL_CALL %ld) ", instr.operand);
+                }
+                break;
             default:
-                snprintf(instr_str, sizeof(instr_str), "(OP_%d %ld) ", instr.opcode, instr.operand);
+                // Primitive sans opérande : son nom vient de la table des primitives
+                if (instr.opcode >= 0 && instr.opcode < OP_COUNT && primitive_names[instr.opcode]) {
+                    snprintf(instr_str, sizeof(instr_str), "%s ", primitive_names[instr.opcode]);
+                } else {
+                    snprintf(instr_str, sizeof(instr_str), "(OP_%d %ld) ", instr.opcode, instr.operand);
+                }
                 break;
         }
 
@@ -1044,305 +2525,573 @@ void print_word_definition_irc(int index, Stack *stack) {
 
     // Envoyer la définition complète
     send_to_channel(def_msg);
+    free(branch_targets);
+}
+
+void print_word_definition_irc(int index, Stack *stack) {
+    if (!currentenv || index < 0 || index >= currentenv->dictionary.count) {
+        send_to_channel("SEE: Unknown word");
+        return;
+    }
+
+    CompiledWord *word = dictWord(&currentenv->dictionary, index);
+    char prefix[512];
+    if (word->verified) { // Effet prouvé à ";"
+        snprintf(prefix, sizeof(prefix), ": %s ( %ld -- %ld ) ", word->name, word->stack_in, word->stack_out);
+    } else {
+        snprintf(prefix, sizeof(prefix), ": %s ", word->name);
+    }
+    if (!word->source) {
+        print_code_irc(word, word->code, word->code_length, prefix);
+        return;
+    }
+    // Source d’origine, puis code exécuté après le peephole
+    print_code_irc(word, word->source, word->source_length, prefix);
+    snprintf(prefix, sizeof(prefix), "\\ optimized (%ld -> %ld): ", word->source_length, word->code_length);
+    print_code_irc(word, word->code, word->code_length, prefix);
+}
+// Empile la trame de l’appelant avant d’entrer dans un mot ; 0 si la pile d’appels est pleine
+static int pushFrame(Env *env, CompiledWord *word, long int ip, int word_index, int unchecked) {
+    if (env->frame_top >= env->frame_capacity) {
+        if (env->frame_capacity >= FRAME_STACK_MAX) {
+            set_error("Call stack overflow");
+            return 0;
+        }
+        int capacity = env->frame_capacity ? env->frame_capacity * 2 : 64;
+        Frame *frames = realloc(env->frames, capacity * sizeof(Frame));
+        if (!frames) {
+            set_error("Call stack allocation failed");
+            return 0;
+        }
+        env->frames = frames;
+        env->frame_capacity = capacity;
+    }
+    env->frames[env->frame_top++] = (Frame){word, ip, word_index, env->loop_stack_top, unchecked};
+    return 1;
+}
+
+static int pushCatch(Env *env, Stack *stack, CompiledWord *word, long int ip, int word_index) {
+    if (env->catch_top >= env->catch_capacity) {
+        int capacity = env->catch_capacity ? env->catch_capacity * 2 : 8;
+        CatchFrame *catches = realloc(env->catches, capacity * sizeof(CatchFrame));
+        if (!catches) {
+            set_error("Catch stack allocation failed");
+            return 0;
+        }
+        env->catches = catches;
+        env->catch_capacity = capacity;
+    }
+    env->catches[env->catch_top++] = (CatchFrame){word, ip, word_index, env->frame_top, env->loop_stack_top,
+                                                  env->return_stack.top, stack->top};
+    return 1;
 }
-void initDictionary(Env *env) {
-    addWord(&env->dictionary, ".S", OP_DOT_S, 0);
-    addWord(&env->dictionary, ".", OP_DOT, 0);
-    addWord(&env->dictionary, "+", OP_ADD, 0);
-    addWord(&env->dictionary, "-", OP_SUB, 0);
-    addWord(&env->dictionary, "*", OP_MUL, 0);
-    addWord(&env->dictionary, "/", OP_DIV, 0);
-    addWord(&env->dictionary, "MOD", OP_MOD, 0);
-    addWord(&env->dictionary, "DUP", OP_DUP, 0);
-    addWord(&env->dictionary, "DROP", OP_DROP, 0);
-    addWord(&env->dictionary, "SWAP", OP_SWAP, 0);
-    addWord(&env->dictionary, "OVER", OP_OVER, 0);
-    addWord(&env->dictionary, "ROT", OP_ROT, 0);
-    addWord(&env->dictionary, ">R", OP_TO_R, 0);
-    addWord(&env->dictionary, "R>", OP_FROM_R, 0);
-    addWord(&env->dictionary, "R@", OP_R_FETCH, 0);
-    addWord(&env->dictionary, "=", OP_EQ, 0);
-    addWord(&env->dictionary, "<", OP_LT, 0);
-    addWord(&env->dictionary, ">", OP_GT, 0);
-    addWord(&env->dictionary, "AND", OP_AND, 0);
-    addWord(&env->dictionary, "OR", OP_OR, 0);
-    addWord(&env->dictionary, "NOT", OP_NOT, 0);
-    addWord(&env->dictionary, "XOR", OP_XOR, 0);
-    addWord(&env->dictionary, "&", OP_BIT_AND, 0);
-    addWord(&env->dictionary, "|", OP_BIT_OR, 0);
-    addWord(&env->dictionary, "^", OP_BIT_XOR, 0);
-    addWord(&env->dictionary, "~", OP_BIT_NOT, 0);
-    addWord(&env->dictionary, "<<", OP_LSHIFT, 0);
-    addWord(&env->dictionary, ">>", OP_RSHIFT, 0);
-    addWord(&env->dictionary, "CR", OP_CR, 0);
-    addWord(&env->dictionary, "EMIT", OP_EMIT, 0);
-    addWord(&env->dictionary, "VARIABLE", OP_VARIABLE, 0);
-    addWord(&env->dictionary, "@", OP_FETCH, 0);
-    addWord(&env->dictionary, "!", OP_STORE, 0);
-    addWord(&env->dictionary, "+!", OP_PLUSSTORE, 0);
-    addWord(&env->dictionary, "DO", OP_DO, 0);
-    addWord(&env->dictionary, "LOOP", OP_LOOP, 0);
-    addWord(&env->dictionary, "I", OP_I, 0);
-    addWord(&env->dictionary, "WORDS", OP_WORDS, 0);
-    addWord(&env->dictionary, "LOAD", OP_LOAD, 0);
-    addWord(&env->dictionary, "CREATE", OP_CREATE, 0);
-    addWord(&env->dictionary, "ALLOT", OP_ALLOT, 0);
-    addWord(&env->dictionary, ".\"", OP_DOT_QUOTE, 0);
-    addWord(&env->dictionary, "CLOCK", OP_CLOCK, 0);
-    addWord(&env->dictionary, "BEGIN", OP_BEGIN, 0);
-    addWord(&env->dictionary, "WHILE", OP_WHILE, 0);
-    addWord(&env->dictionary, "REPEAT", OP_REPEAT, 0);
-    addWord(&env->dictionary, "AGAIN", OP_AGAIN, 0);
-    addWord(&env->dictionary, "SQRT", OP_SQRT, 0);
-    addWord(&env->dictionary, "UNLOOP", OP_UNLOOP, 0);
-    addWord(&env->dictionary, "+LOOP", OP_PLUS_LOOP, 0);
-    addWord(&env->dictionary, "PICK", OP_PICK, 0);
-    addWord(&env->dictionary, "CLEAR-STACK", OP_CLEAR_STACK, 0);
-    addWord(&env->dictionary, "PRINT", OP_PRINT, 0);
-    addWord(&env->dictionary, "NUM-TO-BIN", OP_NUM_TO_BIN, 0);
-    addWord(&env->dictionary, "PRIME?", OP_PRIME_TEST, 0);
-    addWord(&env->dictionary, "FORGET", OP_FORGET, 1); // Immédiat
-    addWord(&env->dictionary, "STRING", OP_STRING, 1); // Immédiat
-    addWord(&env->dictionary, "\"", OP_QUOTE, 0);
-    addWord(&env->dictionary, "2DROP", OP_2DROP, 0);
-    addWord(&env->dictionary, "IMAGE", OP_IMAGE, 0);
-    addWord(&env->dictionary, "TEMP-IMAGE", OP_TEMP_IMAGE, 0);
-        addWord(&env->dictionary, "CLEAR-STRINGS", OP_CLEAR_STRINGS, 0);
-    addWord(&env->dictionary, "DELAY", OP_DELAY, 0);
-         addWord(&env->dictionary, "EXIT", OP_EXIT, 0);
-}
-void executeInstruction(Instruction instr, Stack *stack, long int *ip, CompiledWord *word, int word_index) {
-    if (!currentenv || currentenv->error_flag) return;
-    // printf( "Executing opcode %d at ip=%ld\n", instr.opcode, *ip);
-    mpz_t *a = &mpz_pool[0], *b = &mpz_pool[1], *result = &mpz_pool[2];
+
+// Trame empilée par CATCH sous son xt : au retour normal, OP_CATCH_END retire le CATCH et rend 0
+static Instruction catch_end_code[1] = { { OP_CATCH_END, 0 } };
+static CompiledWord catch_end_word = { .name = NULL, .code = catch_end_code, .code_length = 1 };
+
+// Interpréteur interne : un handler par opcode, enchaînés par goto calculé (ou par switch).
+// Les appels de mots ne récursent pas en C : OP_CALL empile une trame dans currentenv->frames
+// et saute au début de l’appelé, OP_END/OP_EXIT dépilent jusqu’à frame_base.
+// Les erreurs ne sont pas testées entre deux instructions : forth_throw revient par longjmp au
+// setjmp de l’entrée, qui reprend au CATCH le plus proche ou abandonne. Seule l’erreur différée
+// du quota GMP (levée dans l’allocateur) attend le prochain saut ou appel (VM_SAFEPOINT).
+#define VM_SAFEPOINT() do { if (currentenv->error_flag) vm_throw(currentenv->throw_code, NULL); } while (0)
+// Un mot vérifié (verifyWord) dont l’entrée a passé le contrôle de profondeur et de place
+// tourne sur word->unchecked : VM_UNCHECKED marque dans un handler le point d’entrée qui suit
+// ses contrôles de pile. Sans goto calculé, tous les mots gardent leurs contrôles.
+#ifdef FORTH_THREADED
+#define VM_CASE(op) L_##op
+#define VM_UNCHECKED(op) U_##op:
+#define VM_DISPATCH() do { instr = &code[ip]; goto *threaded[ip]; } while (0)
+#else
+#define VM_CASE(op) case op
+#define VM_UNCHECKED(op)
+#define VM_DISPATCH() goto vm_dispatch
+#endif
+#define VM_NEXT do { ip++; VM_DISPATCH(); } while (0)
+#define VM_JUMP(target) do { \
+        ip = (target); \
+        if (ip < 0 || ip > word->code_length) vm_throw(THROW_ABORT, "Invalid branch target"); \
+        VM_SAFEPOINT(); \
+        VM_DISPATCH(); \
+    } while (0)
+
+void executeCompiledWord(CompiledWord *entry, Stack *stack, int entry_index) {
+#ifdef FORTH_THREADED
+    static void *dispatch_table[OP_COUNT + 2] = {
+        [OP_PUSH] = &&L_OP_PUSH,
+        [OP_PUSH_BIG] = &&L_OP_PUSH_BIG,
+        [OP_ADD] = &&L_OP_ADD,
+        [OP_SUB] = &&L_OP_SUB,
+        [OP_MUL] = &&L_OP_MUL,
+        [OP_DIV] = &&L_OP_DIV,
+        [OP_MOD] = &&L_OP_MOD,
+        [OP_DUP] = &&L_OP_DUP,
+        [OP_DROP] = &&L_OP_DROP,
+        [OP_SWAP] = &&L_OP_SWAP,
+        [OP_OVER] = &&L_OP_OVER,
+        [OP_ROT] = &&L_OP_ROT,
+        [OP_TO_R] = &&L_OP_TO_R,
+        [OP_FROM_R] = &&L_OP_FROM_R,
+        [OP_R_FETCH] = &&L_OP_R_FETCH,
+        [OP_SEE] = &&L_OP_SEE,
+        [OP_2DROP] = &&L_OP_2DROP,
+        [OP_EQ] = &&L_OP_EQ,
+        [OP_LT] = &&L_OP_LT,
+        [OP_GT] = &&L_OP_GT,
+        [OP_AND] = &&L_OP_AND,
+        [OP_OR] = &&L_OP_OR,
+        [OP_NOT] = &&L_OP_NOT,
+        [OP_XOR] = &&L_OP_XOR,
+        [OP_CALL] = &&L_OP_CALL,
+        [OP_BRANCH] = &&L_OP_BRANCH,
+        [OP_BRANCH_FALSE] = &&L_OP_BRANCH_FALSE,
+        [OP_END] = &&L_OP_END,
+        [OP_DOT] = &&L_OP_DOT,
+        [OP_DOT_S] = &&L_OP_DOT_S,
+        [OP_EMIT] = &&L_OP_EMIT,
+        [OP_CR] = &&L_OP_CR,
+        [OP_VARIABLE] = &&L_OP_VARIABLE,
+        [OP_STORE] = &&L_OP_STORE,
+        [OP_FETCH] = &&L_OP_FETCH,
+        [OP_ALLOT] = &&L_OP_ALLOT,
+        [OP_IRC_SEND] = &&L_OP_IRC_SEND,
+        [OP_DO] = &&L_OP_DO,
+        [OP_LOOP] = &&L_OP_LOOP,
+        [OP_I] = &&L_OP_I,
+        [OP_J] = &&L_OP_J,
+        [OP_UNLOOP] = &&L_OP_UNLOOP,
+        [OP_LEAVE] = &&L_OP_LEAVE,
+        [OP_FILL] = &&L_OP_FILL,
+        [OP_SUM] = &&L_OP_SUM,
+        [OP_MOVE] = &&L_OP_MOVE,
+        [OP_COUNT_IF] = &&L_OP_COUNT_IF,
+        [OP_MAX] = &&L_OP_MAX,
+        [OP_DOT_PRODUCT] = &&L_OP_DOT_PRODUCT,
+        [OP_STACK_LIMIT] = &&L_OP_STACK_LIMIT,
+        [OP_PLUS_LOOP] = &&L_OP_PLUS_LOOP,
+        [OP_SQRT] = &&L_OP_SQRT,
+        [OP_DOT_QUOTE] = &&L_OP_DOT_QUOTE,
+        [OP_LITSTRING] = &&L_OP_LITSTRING,
+        [OP_CASE] = &&L_OP_CASE,
+        [OP_OF] = &&L_OP_OF,
+        [OP_ENDOF] = &&L_OP_ENDOF,
+        [OP_ENDCASE] = &&L_OP_ENDCASE,
+        [OP_EXIT] = &&L_OP_EXIT,
+        [OP_BEGIN] = &&L_OP_BEGIN,
+        [OP_WHILE] = &&L_OP_WHILE,
+        [OP_REPEAT] = &&L_OP_REPEAT,
+        [OP_UNTIL] = &&L_OP_UNTIL,
+        [OP_AGAIN] = &&L_OP_AGAIN,
+        [OP_BIT_AND] = &&L_OP_BIT_AND,
+        [OP_BIT_OR] = &&L_OP_BIT_OR,
+        [OP_BIT_XOR] = &&L_OP_BIT_XOR,
+        [OP_BIT_NOT] = &&L_OP_BIT_NOT,
+        [OP_LSHIFT] = &&L_OP_LSHIFT,
+        [OP_RSHIFT] = &&L_OP_RSHIFT,
+        [OP_FORGET] = &&L_OP_FORGET,
+        [OP_WORDS] = &&L_OP_WORDS,
+        [OP_LOAD] = &&L_OP_LOAD,
+        [OP_PICK] = &&L_OP_PICK,
+        [OP_ROLL] = &&L_OP_ROLL,
+        [OP_PLUSSTORE] = &&L_OP_PLUSSTORE,
+        [OP_DEPTH] = &&L_OP_DEPTH,
+        [OP_TOP] = &&L_OP_TOP,
+        [OP_NIP] = &&L_OP_NIP,
+        [OP_CREATE] = &&L_OP_CREATE,
+        [OP_STRING] = &&L_OP_STRING,
+        [OP_QUOTE] = &&L_OP_QUOTE,
+        [OP_PRINT] = &&L_OP_PRINT,
+        [OP_NUM_TO_BIN] = &&L_OP_NUM_TO_BIN,
+        [OP_PRIME_TEST] = &&L_OP_PRIME_TEST,
+        [OP_CLEAR_STACK] = &&L_OP_CLEAR_STACK,
+        [OP_CLOCK] = &&L_OP_CLOCK,
+        [OP_IMAGE] = &&L_OP_IMAGE,
+        [OP_TEMP_IMAGE] = &&L_OP_TEMP_IMAGE,
+        [OP_CLEAR_STRINGS] = &&L_OP_CLEAR_STRINGS,
+        [OP_DELAY] = &&L_OP_DELAY,
+        [OP_SQUARE] = &&L_OP_SQUARE,
+        [OP_OVER_ADD] = &&L_OP_OVER_ADD,
+        [OP_PUSH_ADD] = &&L_OP_PUSH_ADD,
+        [OP_PUSH_SUB] = &&L_OP_PUSH_SUB,
+        [OP_PUSH_MUL] = &&L_OP_PUSH_MUL,
+        [OP_EQ_BRANCH_FALSE] = &&L_OP_EQ_BRANCH_FALSE,
+        [OP_LT_BRANCH_FALSE] = &&L_OP_LT_BRANCH_FALSE,
+        [OP_I_ARRAY_FETCH] = &&L_OP_I_ARRAY_FETCH,
+        [OP_TAIL_CALL] = &&L_OP_TAIL_CALL,
+        [OP_CASE_DISPATCH] = &&L_OP_CASE_DISPATCH,
+        [OP_CATCH] = &&L_OP_CATCH,
+        [OP_THROW] = &&L_OP_THROW,
+        [OP_CATCH_END] = &&L_OP_CATCH_END,
+        [OP_COUNT] = &&vm_exit,
+        [OP_COUNT + 1] = &&vm_unknown
+    };
+    // Entrées après les contrôles de pile ; les autres opcodes gardent leur handler complet
+    static void *unchecked_table[OP_COUNT + 2] = {
+        [OP_PUSH] = &&U_OP_PUSH,
+        [OP_ADD] = &&U_OP_ADD,
+        [OP_SUB] = &&U_OP_SUB,
+        [OP_MUL] = &&U_OP_MUL,
+        [OP_DIV] = &&U_OP_DIV,
+        [OP_MOD] = &&U_OP_MOD,
+        [OP_DUP] = &&U_OP_DUP,
+        [OP_DROP] = &&U_OP_DROP,
+        [OP_SWAP] = &&U_OP_SWAP,
+        [OP_OVER] = &&U_OP_OVER,
+        [OP_ROT] = &&U_OP_ROT,
+        [OP_NIP] = &&U_OP_NIP,
+        [OP_EQ] = &&U_OP_EQ,
+        [OP_LT] = &&U_OP_LT,
+        [OP_GT] = &&U_OP_GT,
+        [OP_AND] = &&U_OP_AND,
+        [OP_OR] = &&U_OP_OR,
+        [OP_NOT] = &&U_OP_NOT,
+        [OP_XOR] = &&U_OP_XOR,
+        [OP_I] = &&U_OP_I,
+        [OP_BRANCH_FALSE] = &&U_OP_BRANCH_FALSE,
+        [OP_WHILE] = &&U_OP_WHILE,
+        [OP_UNTIL] = &&U_OP_UNTIL,
+        [OP_SQUARE] = &&U_OP_SQUARE,
+        [OP_OVER_ADD] = &&U_OP_OVER_ADD,
+        [OP_PUSH_ADD] = &&U_OP_PUSH_ADD,
+        [OP_PUSH_SUB] = &&U_OP_PUSH_ADD,
+        [OP_PUSH_MUL] = &&U_OP_PUSH_ADD,
+        [OP_EQ_BRANCH_FALSE] = &&U_OP_EQ_BRANCH_FALSE,
+        [OP_LT_BRANCH_FALSE] = &&U_OP_LT_BRANCH_FALSE
+    };
+    if (!entry) { // Initialisation : compléter et exporter les tables pour threadWord
+        for (int i = 0; i < OP_COUNT; i++) {
+            if (!dispatch_table[i]) dispatch_table[i] = &&vm_unknown;
+        }
+        for (int i = 0; i < OP_COUNT + 2; i++) {
+            if (!unchecked_table[i]) unchecked_table[i] = dispatch_table[i];
+        }
+        vm_dispatch_table = dispatch_table;
+        vm_unchecked_table = unchecked_table;
+        return;
+    }
+    void **threaded;
+#endif
+    int unchecked = 0; // Le mot courant tourne sur word->unchecked
+    if (!currentenv) return;
+    long int frame_base = currentenv->frame_top; // Appels imbriqués (LOAD…) : on ne dépile que nos trames
+    int loop_base = currentenv->loop_stack_top;
+    long int return_base = currentenv->return_stack.top;
+    jmp_buf abort_point;
+    jmp_buf *outer_abort_point = currentenv->abort_point;
+    int outer_catch_base = currentenv->catch_base;
+    // Affectés seulement après setjmp (entrée ou CATCH) : rien à préserver à travers longjmp
+    CompiledWord *word;
+    int word_index;
+    LoopEntry *loop;
+    Instruction *code;
+    Instruction *instr;
+    long int ip;
+    Cell *a = &cell_pool[0], *b = &cell_pool[1], *result = &cell_pool[2];
+    Cell *x, *y; // Opérandes lus en place sur la pile : x reçoit le résultat
     char temp_str[512];
 unsigned long encoded_idx;
     unsigned long type;
     MemoryNode *node;
-    switch (instr.opcode) {
+    currentenv->catch_base = currentenv->catch_top;
+    currentenv->abort_point = &abort_point;
+    if (setjmp(abort_point)) {
+        // Erreur : word, ip… sont indéterminés après longjmp, tout est relu dans le CATCH
+        if (currentenv->catch_top <= currentenv->catch_base) goto vm_abort;
+        CatchFrame *catch = &currentenv->catches[--currentenv->catch_top];
+        currentenv->frame_top = catch->frame_top;
+        currentenv->loop_stack_top = catch->loop_top;
+        if (currentenv->return_stack.top > catch->return_top) currentenv->return_stack.top = catch->return_top;
+        if (stack->top > catch->data_top) stack->top = catch->data_top;
+        while (stack->top < catch->data_top && stack->top + 1 < stack->capacity) cell_set_si(&stack->data[++stack->top], 0);
+        if (currentenv->gmp->live_bytes > currentenv->gmp->quota) gmp_reclaim(currentenv);
+        currentenv->error_flag = 0;
+        push_si(stack, currentenv->throw_code);
+        word_index = catch->word_index;
+        word = (word_index >= 0 && word_index < currentenv->dictionary.count) ?
+               dictWord(&currentenv->dictionary, word_index) : catch->word;
+        ip = catch->ip;
+        unchecked = 0; // Un mot à CATCH n’est jamais vérifié
+        goto vm_resume;
+    }
+    word = entry;
+    word_index = entry_index;
+    goto vm_enter;
+#ifdef FORTH_THREADED
+    {
+#else
+vm_dispatch:
+    if (ip >= word->code_length) goto vm_return;
+    instr = &code[ip];
+    switch (instr->opcode) {
+#endif
  
-case OP_PUSH:
-    if (instr.operand < word->string_count && word->strings[instr.operand]) {
-        if (mpz_set_str(*result, word->strings[instr.operand], 10) == 0) {
-            push(stack, *result);
-        } else {
-            set_error("OP_PUSH: Invalid string number");
-        }
+VM_CASE(OP_PUSH):
+    if (stack->top + 1 >= stack->capacity) {
+        push_si(stack, instr->operand); // Agrandit la pile, ou Stack overflow
+        VM_NEXT;
+    }
+VM_UNCHECKED(OP_PUSH)
+    cell_set_si(&stack->data[++stack->top], instr->operand);
+    VM_NEXT;
+VM_CASE(OP_PUSH_BIG):
+    if (instr->operand >= 0 && instr->operand < word->constant_count) {
+        push_mpz(stack, word->constants[instr->operand]);
     } else {
-        mpz_set_ui(*result, instr.operand);
-        push(stack, *result);
-    }
-    break;
-    push(stack, *result);
-    break;
-        case OP_ADD:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_add(*result, *a, *b);
-            push(stack, *result);
-            break;
-        case OP_SUB:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_sub(*result, *a, *b);
-            push(stack, *result);
-            break;
-        case OP_MUL:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_mul(*result, *a, *b);
-            push(stack, *result);
-            break;
-        case OP_DIV:
-            pop(stack, *b);
-            pop(stack, *a);
-            if (mpz_cmp_ui(*b, 0) == 0) {
-                set_error("Division by zero");
-                push(stack, *a);
-                push(stack, *b);
-            } else {
-                mpz_div(*result, *a, *b);
-                push(stack, *result);
+        vm_throw(THROW_ABORT, "OP_PUSH_BIG: Invalid constant index");
+    }
+    VM_NEXT;
+        VM_CASE(OP_ADD):
+        vm_add:
+            if (stack->top < 1) stack_underflow();
+        VM_UNCHECKED(OP_ADD)
+            x = &stack->data[--stack->top]; y = x + 1;
+            cell_add(x, x, y);
+            VM_NEXT;
+        VM_CASE(OP_SUB):
+        vm_sub:
+            if (stack->top < 1) stack_underflow();
+        VM_UNCHECKED(OP_SUB)
+            x = &stack->data[--stack->top]; y = x + 1;
+            cell_sub(x, x, y);
+            VM_NEXT;
+        VM_CASE(OP_MUL):
+        vm_mul:
+            if (stack->top < 1) stack_underflow();
+        VM_UNCHECKED(OP_MUL)
+            x = &stack->data[--stack->top]; y = x + 1;
+            cell_mul(x, x, y);
+            VM_NEXT;
+        VM_CASE(OP_DIV):
+            if (stack->top < 1) stack_underflow();
+        VM_UNCHECKED(OP_DIV)
+            if (cell_sgn(&stack->data[stack->top]) == 0) {
+                vm_throw(THROW_DIVISION_BY_ZERO, "Division by zero"); // Opérandes laissés sur la pile
             }
-            break;
-        case OP_MOD:
-            pop(stack, *b);
-            pop(stack, *a);
-            if (mpz_cmp_ui(*b, 0) == 0) {
-                set_error("Modulo by zero");
-                push(stack, *a);
-                push(stack, *b);
-            } else {
-                mpz_mod(*result, *a, *b);
-                push(stack, *result);
+            x = &stack->data[--stack->top]; y = x + 1;
+            cell_div(x, x, y);
+            VM_NEXT;
+        VM_CASE(OP_MOD):
+            if (stack->top < 1) stack_underflow();
+        VM_UNCHECKED(OP_MOD)
+            if (cell_sgn(&stack->data[stack->top]) == 0) {
+                vm_throw(THROW_DIVISION_BY_ZERO, "Modulo by zero"); // Opérandes laissés sur la pile
             }
-            break;
+            x = &stack->data[--stack->top]; y = x + 1;
+            cell_mod(x, x, y);
+            VM_NEXT;
             
-        case OP_DUP:
-            if (stack->top >= 0) push(stack, stack->data[stack->top]);
-            else set_error("DUP: Stack underflow");
-            break;
-        case OP_DROP:
-            pop(stack, *a);
-            break;
-        case OP_SWAP:
-            if (stack->top >= 1) {
-                mpz_set(*a, stack->data[stack->top]);
-                mpz_set(stack->data[stack->top], stack->data[stack->top - 1]);
-                mpz_set(stack->data[stack->top - 1], *a);
-            } else set_error("SWAP: Stack underflow");
-            break;
-        case OP_OVER:
-            if (stack->top >= 1) push(stack, stack->data[stack->top - 1]);
-            else set_error("OVER: Stack underflow");
-            break;
-        case OP_ROT:
-            if (stack->top >= 2) {
-                mpz_set(*a, stack->data[stack->top]);
-                mpz_set(stack->data[stack->top], stack->data[stack->top - 2]);
-                mpz_set(stack->data[stack->top - 2], stack->data[stack->top - 1]);
-                mpz_set(stack->data[stack->top - 1], *a);
-            } else set_error("ROT: Stack underflow");
-            break;
-        case OP_TO_R:
-            pop(stack, *a);
-            if (!currentenv->error_flag) {
-                if (currentenv->return_stack.top < STACK_SIZE - 1) {
-                    mpz_set(currentenv->return_stack.data[++currentenv->return_stack.top], *a);
-                } else {
-                    set_error(">R: Return stack overflow");
-                    push(stack, *a);
-                }
+        VM_CASE(OP_DUP):
+            if (stack->top < 0) vm_throw(THROW_STACK_UNDERFLOW, "DUP: Stack underflow");
+            if (stack->top + 1 >= stack->capacity) {
+                push(stack, &stack->data[stack->top]);
+                VM_NEXT;
             }
-            break;
-        case OP_FROM_R:
-            if (currentenv->return_stack.top >= 0) {
-                mpz_set(*a, currentenv->return_stack.data[currentenv->return_stack.top--]);
-                push(stack, *a);
-            } else set_error("R>: Return stack underflow");
-            break;
-        case OP_R_FETCH:
-            if (currentenv->return_stack.top >= 0) push(stack, currentenv->return_stack.data[currentenv->return_stack.top]);
-            else set_error("R@: Return stack underflow");
-            break;
-        case OP_SEE:
+        VM_UNCHECKED(OP_DUP)
+            cell_set(&stack->data[stack->top + 1], &stack->data[stack->top]);
+            stack->top++;
+            VM_NEXT;
+        VM_CASE(OP_DROP):
+            if (stack->top < 0) stack_underflow();
+        VM_UNCHECKED(OP_DROP)
+            stack->top--;
+            stack_release(stack, stack->top + 1);
+            VM_NEXT;
+        VM_CASE(OP_SWAP):
+            if (stack->top < 1) vm_throw(THROW_STACK_UNDERFLOW, "SWAP: Stack underflow");
+        VM_UNCHECKED(OP_SWAP)
+            cell_swap(&stack->data[stack->top], &stack->data[stack->top - 1]);
+            VM_NEXT;
+        VM_CASE(OP_OVER):
+            if (stack->top < 1) vm_throw(THROW_STACK_UNDERFLOW, "OVER: Stack underflow");
+            if (stack->top + 1 >= stack->capacity) {
+                push(stack, &stack->data[stack->top - 1]);
+                VM_NEXT;
+            }
+        VM_UNCHECKED(OP_OVER)
+            cell_set(&stack->data[stack->top + 1], &stack->data[stack->top - 1]);
+            stack->top++;
+            VM_NEXT;
+        VM_CASE(OP_ROT):
+            if (stack->top < 2) vm_throw(THROW_STACK_UNDERFLOW, "ROT: Stack underflow");
+        VM_UNCHECKED(OP_ROT)
+            cell_swap(&stack->data[stack->top - 2], &stack->data[stack->top - 1]);
+            cell_swap(&stack->data[stack->top - 1], &stack->data[stack->top]);
+            VM_NEXT;
+        VM_CASE(OP_TO_R):
+            if (stack->top < 0) {
+                pop(stack, a);
+            } else if (stack_reserve(&currentenv->return_stack, currentenv->return_stack.top + 2)) {
+                cell_swap(&currentenv->return_stack.data[++currentenv->return_stack.top], &stack->data[stack->top--]);
+            } else {
+                vm_throw(THROW_RSTACK_OVERFLOW, ">R: Return stack overflow");
+            }
+            VM_NEXT;
+        VM_CASE(OP_FROM_R):
+            if (currentenv->return_stack.top < 0) {
+                vm_throw(THROW_RSTACK_UNDERFLOW, "R>: Return stack underflow");
+            } else if ((x = push_slot(stack))) {
+                cell_swap(x, &currentenv->return_stack.data[currentenv->return_stack.top--]);
+            }
+            VM_NEXT;
+        VM_CASE(OP_R_FETCH):
+            if (currentenv->return_stack.top >= 0) push(stack, &currentenv->return_stack.data[currentenv->return_stack.top]);
+            else vm_throw(THROW_RSTACK_UNDERFLOW, "R@: Return stack underflow");
+            VM_NEXT;
+        VM_CASE(OP_SEE):
        
     if (currentenv->compiling || word_index >= 0) { // Mode compilé ou dans une définition
-        print_word_definition_irc(instr.operand, stack);
+        print_word_definition_irc(instr->operand, stack);
     } else { // Mode immédiat
-        pop(stack, *a);
-        if (!currentenv->error_flag && mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) < currentenv->dictionary.count) {
-            print_word_definition_irc(mpz_get_si(*a), stack);
-        } else if (!currentenv->error_flag) {
-            set_error("SEE: Invalid word index");
-        }
-    }  
-    break;
-    case OP_2DROP:
-    if (stack->top >= 1) {
-        pop(stack, mpz_pool[0]); // Dépile le premier élément
-        pop(stack, mpz_pool[0]); // Dépile le second élément
-    } else {
-        set_error("2DROP: Stack underflow");
-    }
-    break;
-        case OP_EQ:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_set_si(*result, mpz_cmp(*a, *b) == 0);
-            push(stack, *result);
-            break;
-        case OP_LT:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_set_si(*result, mpz_cmp(*a, *b) < 0);
-            push(stack, *result);
-            break;
-        case OP_GT:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_set_si(*result, mpz_cmp(*a, *b) > 0);
-            push(stack, *result);
-            break;
-case OP_AND:
-    pop(stack, *b);
-    pop(stack, *a);
-    mpz_set_si(*result, (mpz_cmp_ui(*a, 0) != 0) && (mpz_cmp_ui(*b, 0) != 0));
-    push(stack, *result);
-    break;
-case OP_OR:
-    pop(stack, *b);
-    pop(stack, *a);
-    mpz_set_si(*result, (mpz_cmp_ui(*a, 0) != 0) || (mpz_cmp_ui(*b, 0) != 0));
-    push(stack, *result);
-    break;
-        case OP_NOT:
-            pop(stack, *a);
-            mpz_set_si(*result, mpz_cmp_ui(*a, 0) == 0);
-            push(stack, *result);
-            break;
-        case OP_XOR:
-        pop(stack, *b);
-        pop(stack, *a);
-        int a_true = (mpz_cmp_ui(*a, 0) != 0);
-        int b_true = (mpz_cmp_ui(*b, 0) != 0);
-        mpz_set_si(*result, (a_true != b_true)); // Vrai si exactement une des deux est vraie
-        push(stack, *result);
-        break;
-case OP_CALL:
-    if (instr.operand >= 0 && instr.operand < currentenv->dictionary.count) {
-        executeCompiledWord(&currentenv->dictionary.words[instr.operand], stack, instr.operand);
+        pop(stack, a);
+        if (a->tag == CELL_SMALL && cell_get_si(a) >= 0 && cell_get_si(a) < currentenv->dictionary.count) {
+            print_word_definition_irc(cell_get_si(a), stack);
+        } else {
+            vm_throw(THROW_ABORT, "SEE: Invalid word index");
+        }
+    }  
+    VM_NEXT;
+    VM_CASE(OP_2DROP):
+    if (stack->top >= 1) {
+        stack->top -= 2;
+        stack_release(stack, stack->top + 2);
     } else {
-        set_error("Invalid word index");
-    }
-    break;
-        case OP_BRANCH:
-            *ip = instr.operand - 1;
-            break;
-        case OP_BRANCH_FALSE:
-            pop(stack, *a);
-            if (mpz_cmp_ui(*a, 0) == 0) *ip = instr.operand - 1;
-            break;
-        case OP_END:
-            *ip = word->code_length;
-            break;
-        case OP_DOT:
-            pop(stack, *a);
-            mpz_get_str(temp_str, 10, *a);
-            send_to_channel(temp_str);
-            break;
+        vm_throw(THROW_STACK_UNDERFLOW, "2DROP: Stack underflow");
+    }
+    VM_NEXT;
+        VM_CASE(OP_EQ):
+        vm_eq:
+            if (stack->top < 1) stack_underflow();
+        VM_UNCHECKED(OP_EQ)
+            x = &stack->data[--stack->top]; y = x + 1;
+            cell_set_si(x, cell_cmp(x, y) == 0);
+            VM_NEXT;
+        VM_CASE(OP_LT):
+        vm_lt:
+            if (stack->top < 1) stack_underflow();
+        VM_UNCHECKED(OP_LT)
+            x = &stack->data[--stack->top]; y = x + 1;
+            cell_set_si(x, cell_cmp(x, y) < 0);
+            VM_NEXT;
+        VM_CASE(OP_GT):
+            if (stack->top < 1) stack_underflow();
+        VM_UNCHECKED(OP_GT)
+            x = &stack->data[--stack->top]; y = x + 1;
+            cell_set_si(x, cell_cmp(x, y) > 0);
+            VM_NEXT;
+VM_CASE(OP_AND):
+    if (stack->top < 1) stack_underflow();
+VM_UNCHECKED(OP_AND)
+    x = &stack->data[--stack->top]; y = x + 1;
+    cell_set_si(x, (cell_sgn(x) != 0) && (cell_sgn(y) != 0));
+    VM_NEXT;
+VM_CASE(OP_OR):
+    if (stack->top < 1) stack_underflow();
+VM_UNCHECKED(OP_OR)
+    x = &stack->data[--stack->top]; y = x + 1;
+    cell_set_si(x, (cell_sgn(x) != 0) || (cell_sgn(y) != 0));
+    VM_NEXT;
+        VM_CASE(OP_NOT):
+            if (stack->top < 0) stack_underflow();
+        VM_UNCHECKED(OP_NOT)
+            cell_set_si(&stack->data[stack->top], cell_sgn(&stack->data[stack->top]) == 0);
+            VM_NEXT;
+        VM_CASE(OP_XOR):
+        if (stack->top < 1) stack_underflow();
+        VM_UNCHECKED(OP_XOR)
+        x = &stack->data[--stack->top]; y = x + 1;
+        cell_set_si(x, (cell_sgn(x) != 0) != (cell_sgn(y) != 0));
+        VM_NEXT;
+VM_CASE(OP_CALL):
+    if (instr->operand >= 0 && instr->operand < currentenv->dictionary.count) {
+        if (!pushFrame(currentenv, word, ip + 1, word_index, unchecked)) goto vm_abort;
+        word_index = instr->operand;
+        word = dictWord(&currentenv->dictionary, word_index);
+        goto vm_enter;
+    }
+    vm_throw(THROW_ABORT, "Invalid word index");
+VM_CASE(OP_TAIL_CALL): // CALL suivi de END/EXIT : l’appelé remplace le mot courant
+    if (instr->operand >= 0 && instr->operand < currentenv->dictionary.count) {
+        word_index = instr->operand;
+        word = dictWord(&currentenv->dictionary, word_index);
+        goto vm_enter;
+    }
+    vm_throw(THROW_ABORT, "Invalid word index");
+VM_CASE(OP_CATCH): // ( i*x xt -- j*x 0 | i*x n ) : xt est un index de mot (')
+    pop(stack, a);
+    if (a->tag != CELL_SMALL || a->small < 0 || a->small >= currentenv->dictionary.count) {
+        push(stack, a);
+        vm_throw(THROW_ABORT, "CATCH: Invalid word index");
+    }
+    if (!pushCatch(currentenv, stack, word, ip + 1, word_index)) VM_NEXT;
+    // Trames : l’appelant, puis catch_end_word qui rend 0 si xt revient normalement
+    if (!pushFrame(currentenv, word, ip + 1, word_index, 0) || !pushFrame(currentenv, &catch_end_word, 0, -1, 0)) goto vm_abort;
+    word_index = a->small;
+    word = dictWord(&currentenv->dictionary, word_index);
+    goto vm_enter;
+VM_CASE(OP_CATCH_END):
+    if (currentenv->catch_top > currentenv->catch_base) currentenv->catch_top--;
+    push_si(stack, 0);
+    VM_NEXT;
+VM_CASE(OP_THROW): // ( n -- ) 0 ne fait rien, sinon erreur de code n jusqu’au CATCH le plus proche
+    pop(stack, a);
+    if (cell_sgn(a) == 0) VM_NEXT;
+    {
+        long int code = a->tag == CELL_SMALL ? a->small : THROW_ABORT;
+        snprintf(temp_str, sizeof(temp_str), "Uncaught THROW %ld", code);
+        vm_throw(code, temp_str);
+    }
+    VM_NEXT;
+        VM_CASE(OP_BRANCH):
+            VM_JUMP(instr->operand);
+        VM_CASE(OP_BRANCH_FALSE):
+            if (stack->top < 0) stack_underflow();
+        VM_UNCHECKED(OP_BRANCH_FALSE)
+            if (cell_sgn(&stack->data[stack->top--]) == 0) VM_JUMP(instr->operand);
+            VM_NEXT;
+        VM_CASE(OP_END):
+            goto vm_return;
+        VM_CASE(OP_DOT):
+            pop(stack, a);
+            if (a->tag == CELL_SMALL) {
+                snprintf(temp_str, sizeof(temp_str), "%ld", a->small);
+                send_to_channel(temp_str);
+            } else {
+                char *num = cell_get_str(a); // Peut dépasser temp_str
+                send_to_channel(num);
+                free(num);
+            }
+            VM_NEXT;
  
-        case OP_DOT_S:
+        VM_CASE(OP_DOT_S):
             if (stack->top >= 0) {
-                char stack_str[512] = "<";
-                char num_str[128];
-                snprintf(num_str, sizeof(num_str), "%ld", stack->top + 1);
-                strcat(stack_str, num_str);
-                strcat(stack_str, "> ");
-                for (int i = 0; i <= stack->top; i++) {
-                    mpz_get_str(num_str, 10, stack->data[i]);
-                    strcat(stack_str, num_str);
-                    if (i < stack->top) strcat(stack_str, " ");
+                char stack_str[512];
+                size_t pos = snprintf(stack_str, sizeof(stack_str), "<%ld> ", stack->top + 1);
+                for (int i = 0; i <= stack->top && pos < sizeof(stack_str) - 1; i++) {
+                    char *num_str = cell_get_str(&stack->data[i]);
+                    pos += snprintf(stack_str + pos, sizeof(stack_str) - pos, "%s%s", num_str, i < stack->top ? " " : "");
+                    free(num_str);
                 }
                 send_to_channel(stack_str);
             } else send_to_channel("<0>");
-            break;
-case OP_EMIT:
+            VM_NEXT;
+VM_CASE(OP_EMIT):
     if (stack->top >= 0) {
-        pop(stack, *a);
-        char c = (char)mpz_get_si(*a);
+        pop(stack, a);
+        char c = (char)cell_get_si(a);
         if (currentenv->buffer_pos < BUFFER_SIZE - 1) {
             currentenv->output_buffer[currentenv->buffer_pos++] = c;
             currentenv->output_buffer[currentenv->buffer_pos] = '\0';  // Terminer la chaîne
         } else {
-            set_error("Output buffer overflow");
+            vm_throw(THROW_ABORT, "Output buffer overflow");
         }
     } else {
-        set_error("EMIT: Stack underflow");
+        vm_throw(THROW_STACK_UNDERFLOW, "EMIT: Stack underflow");
     }
-    break;
+    VM_NEXT;
 
-case OP_CR:
+VM_CASE(OP_CR):
     if (currentenv->buffer_pos < BUFFER_SIZE - 1) {
         currentenv->output_buffer[currentenv->buffer_pos++] = '\n';
         currentenv->output_buffer[currentenv->buffer_pos] = '\0';
@@ -1352,59 +3101,55 @@ case OP_CR:
         currentenv->buffer_pos = 0;  // Réinitialiser le buffer
         memset(currentenv->output_buffer, 0, BUFFER_SIZE);
     }
-    break;
-case OP_VARIABLE:
-    if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
-        char *name = word->strings[instr.operand];
+    VM_NEXT;
+VM_CASE(OP_VARIABLE):
+    if (instr->operand >= 0 && instr->operand < word->string_count && word->strings[instr->operand]) {
+        char *name = word->strings[instr->operand];
         if (findCompiledWordIndex(name) >= 0) {
             char msg[512];
             snprintf(msg, sizeof(msg), "VARIABLE: '%s' already defined", name);
-            set_error(msg);
+            vm_throw(THROW_ABORT, msg);
         } else {
             unsigned long index = memory_create(&currentenv->memory_list, name, TYPE_VAR);
             if (index == 0) {
-                set_error("VARIABLE: Memory creation failed");
+                vm_throw(THROW_ABORT, "VARIABLE: Memory creation failed");
             } else if (currentenv->dictionary.count < currentenv->dictionary.capacity) {
                 int dict_idx = currentenv->dictionary.count++;
-                currentenv->dictionary.words[dict_idx].name = strdup(name);
-                currentenv->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-                currentenv->dictionary.words[dict_idx].code[0].operand = index;
-                currentenv->dictionary.words[dict_idx].code_length = 1;
-                currentenv->dictionary.words[dict_idx].string_count = 0;
+                dictWord(&currentenv->dictionary, dict_idx)->name = arena_strdup(&currentenv->arena, name);
+                dictIndexAdd(&currentenv->dictionary, dict_idx);
+                setWordInstruction(&currentenv->dictionary, dictWord(&currentenv->dictionary, dict_idx), OP_PUSH, index);
+                dictWord(&currentenv->dictionary, dict_idx)->string_count = 0;
             } else {
                 resizeDynamicDictionary(&currentenv->dictionary);
                 int dict_idx = currentenv->dictionary.count++;
-                currentenv->dictionary.words[dict_idx].name = strdup(name);
-                currentenv->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-                currentenv->dictionary.words[dict_idx].code[0].operand = index;
-                currentenv->dictionary.words[dict_idx].code_length = 1;
-                currentenv->dictionary.words[dict_idx].string_count = 0;
+                dictWord(&currentenv->dictionary, dict_idx)->name = arena_strdup(&currentenv->arena, name);
+                dictIndexAdd(&currentenv->dictionary, dict_idx);
+                setWordInstruction(&currentenv->dictionary, dictWord(&currentenv->dictionary, dict_idx), OP_PUSH, index);
+                dictWord(&currentenv->dictionary, dict_idx)->string_count = 0;
             }
         }
     } else {
-        set_error("Invalid variable name");
+        vm_throw(THROW_ABORT, "Invalid variable name");
     }
-    break;
-case OP_STORE:
+    VM_NEXT;
+VM_CASE(OP_STORE):
     if (stack->top < 0) {
-        set_error("STORE: Stack underflow for address");
-        break;
+        vm_throw(THROW_STACK_UNDERFLOW, "STORE: Stack underflow for address");
     }
     char debug_msg[512];
     /*  snprintf(debug_msg, sizeof(debug_msg), "STORE: Starting, stack_top=%d", stack->top);
     send_to_channel(debug_msg);
  */
-    pop(stack, *result); // encoded_idx
-    encoded_idx = mpz_get_ui(*result);
+    pop(stack, result); // encoded_idx
+    encoded_idx = cell_get_ui(result);
    /*   snprintf(debug_msg, sizeof(debug_msg), "STORE: Popped encoded_idx=%lu, stack_top=%d", encoded_idx, stack->top);
     send_to_channel(debug_msg);
  */
     node = memory_get(&currentenv->memory_list, encoded_idx);
     if (!node) {
         snprintf(debug_msg, sizeof(debug_msg), "STORE: Invalid memory index for encoded_idx=%lu", encoded_idx);
-        set_error(debug_msg);
-        push(stack, *result);
-        break;
+        push(stack, result);
+        vm_throw(THROW_ABORT, debug_msg);
     }
     type = node->type;
      /* snprintf(debug_msg, sizeof(debug_msg), "STORE: Found node %s with type=%lu, stack_top=%d", node->name, type, stack->top);
@@ -1412,11 +3157,10 @@ case OP_STORE:
  */
     if (type == TYPE_VAR) {
         if (stack->top < 0) {
-            set_error("STORE: Stack underflow for variable value");
-            push(stack, *result);
-            break;
+            push(stack, result);
+            vm_throw(THROW_STACK_UNDERFLOW, "STORE: Stack underflow for variable value");
         }
-        pop(stack, *a);
+        pop(stack, a);
         memory_store(&currentenv->memory_list, encoded_idx, a);
         /*  snprintf(debug_msg, sizeof(debug_msg), "STORE: Set %s = %s", node->name, mpz_get_str(NULL, 10, *a));
         send_to_channel(debug_msg);
@@ -1424,79 +3168,73 @@ case OP_STORE:
          
     } else if (type == TYPE_ARRAY) {
         if (stack->top < 1) {
-            set_error("STORE: Stack underflow for array operation");
-            push(stack, *result);
-            break;
+            push(stack, result);
+            vm_throw(THROW_STACK_UNDERFLOW, "STORE: Stack underflow for array operation");
         }
-        pop(stack, *a); // offset
-        pop(stack, *b); // valeur
-        int offset = mpz_get_si(*a);
+        pop(stack, a); // offset
+        pop(stack, b); // valeur
+        int offset = cell_get_si(a);
          /*  snprintf(debug_msg, sizeof(debug_msg), "STORE: Array operation on %s, offset=%d, value=%s", node->name, offset, mpz_get_str(NULL, 10, *b));
         send_to_channel(debug_msg);
         */
         if (offset >= 0 && offset < node->value.array.size) {
-            mpz_set(node->value.array.data[offset], *b);
+            if (!memory_array_store(node, offset, b)) vm_throw(THROW_ABORT, "STORE: Memory allocation failed");
             /* snprintf(debug_msg, sizeof(debug_msg), "STORE: Set %s[%d] = %s", node->name, offset, mpz_get_str(NULL, 10, *b));
             send_to_channel(debug_msg);
             */ 
         } else {
             snprintf(debug_msg, sizeof(debug_msg), "STORE: Array index %d out of bounds (size=%lu)", offset, node->value.array.size);
-            set_error(debug_msg);
-            push(stack, *b);
-            push(stack, *a);
-            push(stack, *result);
+            push(stack, b);
+            push(stack, a);
+            push(stack, result);
+            vm_throw(THROW_ABORT, debug_msg);
         }
     } else if (type == TYPE_STRING) {
         if (stack->top < 0) {
-            set_error("STORE: Stack underflow for string value");
-            push(stack, *result);
-            break;
+            push(stack, result);
+            vm_throw(THROW_STACK_UNDERFLOW, "STORE: Stack underflow for string value");
         }
-        pop(stack, *a); // index dans string_stack
-        int str_idx = mpz_get_si(*a);
-        if (mpz_fits_slong_p(*a) && str_idx >= 0 && str_idx <= currentenv->string_stack_top) {
-            char *str = currentenv->string_stack[str_idx];
+        pop(stack, a); // handle dans la pile de chaînes
+        StringSlot *slot = string_slot(a);
+        if (slot) {
+            char *str = slot->str;
             if (str) {
-                memory_store(&currentenv->memory_list, encoded_idx, str);
-                for (int i = str_idx; i < currentenv->string_stack_top; i++) {
-                    currentenv->string_stack[i] = currentenv->string_stack[i + 1];
-                }
-                currentenv->string_stack[currentenv->string_stack_top--] = NULL;
+                // La référence passe de la pile de chaînes au nœud, sans copie
+                memory_store_string(&currentenv->memory_list, encoded_idx, take_string(slot));
                 /* snprintf(debug_msg, sizeof(debug_msg), "STORE: Set %s = %s", node->name, str);
                 send_to_channel(debug_msg);
                 */ 
             } else {
-                set_error("STORE: No string at stack index");
-                push(stack, *a);
-                push(stack, *result);
+                push(stack, a);
+                push(stack, result);
+                vm_throw(THROW_ABORT, "STORE: No string at stack index");
             }
         } else {
-            set_error("STORE: Invalid string stack index");
-            push(stack, *a);
-            push(stack, *result);
+            push(stack, a);
+            push(stack, result);
+            vm_throw(THROW_ABORT, "STORE: Invalid string stack index");
         }
     } else {
-        set_error("STORE: Unknown type");
-        push(stack, *result);
+        push(stack, result);
+        vm_throw(THROW_ABORT, "STORE: Unknown type");
     }
-    break;
+    VM_NEXT;
  
-case OP_FETCH:
+VM_CASE(OP_FETCH):
+vm_fetch:
     if (stack->top < 0) {
-        set_error("FETCH: Stack underflow for address");
-        break;
+        vm_throw(THROW_STACK_UNDERFLOW, "FETCH: Stack underflow for address");
     }
-    pop(stack, *result); // encoded_idx (ex. ZOZO = 268435456)
-    encoded_idx = mpz_get_ui(*result);
+    pop(stack, result); // encoded_idx (ex. ZOZO = 268435456)
+    encoded_idx = cell_get_ui(result);
     // char debug_msg[512];
     /* snprintf(debug_msg, sizeof(debug_msg), "FETCH: Popped encoded_idx=%lu", encoded_idx);
     send_to_channel(debug_msg);
 */
     node = memory_get(&currentenv->memory_list, encoded_idx);
     if (!node) {
-        set_error("FETCH: Invalid memory index");
-        push(stack, *result);
-        break;
+        push(stack, result);
+        vm_throw(THROW_ABORT, "FETCH: Invalid memory index");
     }
     type = node->type; // Type réel du nœud
     /* snprintf(debug_msg, sizeof(debug_msg), "FETCH: Found %s, type=%lu, stack_top=%d", node->name, type, stack->top);
@@ -1507,196 +3245,185 @@ case OP_FETCH:
         /* snprintf(debug_msg, sizeof(debug_msg), "FETCH: Got variable %s = %s", node->name, mpz_get_str(NULL, 10, *result));
         send_to_channel(debug_msg);
         */
-        push(stack, *result);
+        push(stack, result);
     } else if (type == TYPE_ARRAY) {
         if (stack->top < 0) {
-            set_error("FETCH: Stack underflow for array offset");
-            push(stack, *result);
-            break;
+            push(stack, result);
+            vm_throw(THROW_STACK_UNDERFLOW, "FETCH: Stack underflow for array offset");
         }
-        pop(stack, *a); // offset (ex. 5)
-        int offset = mpz_get_si(*a);
+        pop(stack, a); // offset (ex. 5)
+        int offset = cell_get_si(a);
         /* snprintf(debug_msg, sizeof(debug_msg), "FETCH: Array offset=%d", offset);
         send_to_channel(debug_msg);
         */
         if (offset >= 0 && offset < node->value.array.size) {
-            mpz_set(*result, node->value.array.data[offset]);
+            memory_array_fetch(node, offset, result);
             /* snprintf(debug_msg, sizeof(debug_msg), "FETCH: Got %s[%d] = %s", node->name, offset, mpz_get_str(NULL, 10, *result));
             send_to_channel(debug_msg);
             */ 
-            push(stack, *result);
+            push(stack, result);
         } else {
             snprintf(debug_msg, sizeof(debug_msg), "FETCH: Array index %d out of bounds (size=%lu)", offset, node->value.array.size);
-            set_error(debug_msg);
-            push(stack, *a);
-            push(stack, *result);
+            push(stack, a);
+            push(stack, result);
+            vm_throw(THROW_ABORT, debug_msg);
         }
     } else if (type == TYPE_STRING) {
-        char *str;
-        memory_fetch(&currentenv->memory_list, encoded_idx, &str);
-        if (str) {
-            push_string(strdup(str));
-            free(str);
-            mpz_set_si(*result, currentenv->string_stack_top);
-            push(stack, *result);
-        } else {
-            push_string(NULL);
-            mpz_set_si(*result, currentenv->string_stack_top);
-            push(stack, *result);
-        }
+        // Nouvelle référence sur la chaîne du nœud, sans copie (NULL si jamais affectée)
+        push_string_handle(stack, fstr_ref(memory_fetch_string(&currentenv->memory_list, encoded_idx)));
     } else {
-        set_error("FETCH: Unknown type");
-        push(stack, *result);
+        push(stack, result);
+        vm_throw(THROW_ABORT, "FETCH: Unknown type");
     }
-    break;
+    VM_NEXT;
     
  
  
- case OP_ALLOT:
+ VM_CASE(OP_ALLOT):
     if (stack->top < 1) { // Vérifie 2 éléments
-        set_error("ALLOT: Stack underflow");
-        break;
+        vm_throw(THROW_STACK_UNDERFLOW, "ALLOT: Stack underflow");
     }
-    pop(stack, *a); // Taille
-    pop(stack, *result); // encoded_idx
-    encoded_idx = mpz_get_ui(*result);
+    pop(stack, a); // Taille
+    pop(stack, result); // encoded_idx
+    encoded_idx = cell_get_ui(result);
     node = memory_get(&currentenv->memory_list, encoded_idx);
     if (!node) {
-        set_error("ALLOT: Invalid memory index");
-        push(stack, *result);
-        push(stack, *a);
-        break;
+        push(stack, result);
+        push(stack, a);
+        vm_throw(THROW_ABORT, "ALLOT: Invalid memory index");
     }
     if (node->type != TYPE_ARRAY) {
-        set_error("ALLOT: Must be an array");
-        push(stack, *result);
-        push(stack, *a);
-        break;
+        push(stack, result);
+        push(stack, a);
+        vm_throw(THROW_ABORT, "ALLOT: Must be an array");
     }
-    int size = mpz_get_si(*a);
+    int size = cell_get_si(a);
     if (size < 0) { // Accepte 0, mais négatif interdit
-        set_error("ALLOT: Size must be non-negative");
-        push(stack, *result);
-        push(stack, *a);
-        break;
-    }
-    unsigned long new_size = node->value.array.size + size;
-    mpz_t *new_array = realloc(node->value.array.data, new_size * sizeof(mpz_t));
-    if (!new_array) {
-        set_error("ALLOT: Memory allocation failed");
-        push(stack, *result);
-        push(stack, *a);
-        break;
-    }
-    node->value.array.data = new_array;
-    for (unsigned long i = node->value.array.size; i < new_size; i++) {
-        mpz_init_set_ui(node->value.array.data[i], 0);
-    }
-    node->value.array.size = new_size;
-    break;
- 
-           case OP_IRC_SEND:
-            pop(stack, *a);
-            if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
-                send_to_channel(word->strings[instr.operand]);
-            } else set_error("Invalid IRC send string");
-            break;
-case OP_DO:
-    if (stack->top < 1) {
-        set_error("DO: Stack underflow");
-        break;
-    }
-    pop(stack, *b); // index initial
-    pop(stack, *a); // limite
-    if (currentenv->return_stack.top + 3 >= STACK_SIZE) {
-        set_error("DO: Return stack overflow");
-        push(stack, *a);
-        push(stack, *b);
-        break;
-    }
-    currentenv->return_stack.top++;
-    mpz_set(currentenv->return_stack.data[currentenv->return_stack.top], *a); // limite
-    currentenv->return_stack.top++;
-    mpz_set(currentenv->return_stack.data[currentenv->return_stack.top], *b); // index
-    currentenv->return_stack.top++;
-    mpz_set_si(currentenv->return_stack.data[currentenv->return_stack.top], *ip + 1); // adresse de retour
-    break;
-
-case OP_LOOP:
-    if (currentenv->return_stack.top < 2) {
-        set_error("LOOP: Return stack underflow");
-        break;
+        push(stack, result);
+        push(stack, a);
+        vm_throw(THROW_ABORT, "ALLOT: Size must be non-negative");
     }
-    mpz_add_ui(*result, currentenv->return_stack.data[currentenv->return_stack.top - 1], 1); // index + 1
-    if (mpz_cmp(*result, currentenv->return_stack.data[currentenv->return_stack.top - 2]) < 0) { // index < limit
-        mpz_set(currentenv->return_stack.data[currentenv->return_stack.top - 1], *result);
-        *ip = instr.operand - 1; // Retour à l'instruction après DO
-    } else {
-        currentenv->return_stack.top -= 3; // Dépiler limit, index, addr
+    if (!memory_array_resize(node, node->value.array.size + size)) {
+        push(stack, result);
+        push(stack, a);
+        vm_throw(THROW_ABORT, "ALLOT: Memory allocation failed");
     }
-    break;
-
-case OP_I:
-    if (currentenv->return_stack.top < 1) {
-        set_error("I: Return stack underflow");
-        break;
+    VM_NEXT;
+ 
+           VM_CASE(OP_IRC_SEND):
+            pop(stack, a);
+            if (instr->operand >= 0 && instr->operand < word->string_count && word->strings[instr->operand]) {
+                send_to_channel(word->strings[instr->operand]);
+            } else vm_throw(THROW_ABORT, "Invalid IRC send string");
+            VM_NEXT;
+VM_CASE(OP_DO):
+    if (stack->top < 1) {
+        vm_throw(THROW_STACK_UNDERFLOW, "DO: Stack underflow");
     }
-    push(stack, currentenv->return_stack.data[currentenv->return_stack.top - 1]); // Pousse l'index actuel
-    break;
-
-case OP_J:
-    if (currentenv->return_stack.top >= 1) {
-        if (currentenv->return_stack.top >= 4) {
-            // Boucle imbriquée : lit l’indice de la boucle externe
-            push(stack, currentenv->return_stack.data[currentenv->return_stack.top - 4]);
+    if (currentenv->loop_stack_top >= currentenv->loop_capacity) {
+        int cap = currentenv->loop_capacity ? currentenv->loop_capacity * 2 : 8;
+        LoopEntry *grown = cap <= LOOP_STACK_SIZE ? realloc(currentenv->loop_stack, cap * sizeof(LoopEntry)) : NULL;
+        if (!grown) {
+            vm_throw(THROW_ABORT, "DO: Loop stack overflow");
+        }
+        for (int i = currentenv->loop_capacity; i < cap; i++) {
+            cell_init(&grown[i].index);
+            cell_init(&grown[i].limit);
+        }
+        currentenv->loop_stack = grown;
+        currentenv->loop_capacity = cap;
+    }
+    loop = &currentenv->loop_stack[currentenv->loop_stack_top++];
+    cell_swap(&loop->index, &stack->data[stack->top--]); // index initial
+    cell_swap(&loop->limit, &stack->data[stack->top--]); // limite
+    VM_NEXT;
+
+VM_CASE(OP_LOOP):
+    if (currentenv->loop_stack_top <= 0) {
+        vm_throw(THROW_ABORT, "LOOP without DO");
+    }
+    loop = &currentenv->loop_stack[currentenv->loop_stack_top - 1];
+    {
+        long int next;
+        // DO entre au moins une fois : l’indice peut déjà valoir LONG_MAX
+        if (loop->index.tag == CELL_SMALL && loop->limit.tag == CELL_SMALL &&
+            !__builtin_add_overflow(loop->index.small, 1, &next)) {
+            loop->index.small = next;
+            if (next < loop->limit.small) VM_JUMP(instr->operand);
         } else {
-            // Boucle externe seule : lit l’indice courant
-            push(stack, currentenv->return_stack.data[currentenv->return_stack.top - 1]);
+            cell_set_si(result, 1);
+            cell_add(&loop->index, &loop->index, result);
+            if (cell_cmp(&loop->index, &loop->limit) < 0) VM_JUMP(instr->operand); // Retour à l'instruction après DO
         }
-    } else {
-        set_error("J: No outer loop");
     }
-    break;
-        case OP_UNLOOP:
-    if (currentenv->return_stack.top >= 2) {
-        currentenv->return_stack.top -= 3;  // Dépile limit, index, addr
-    } else {
-        set_error("UNLOOP without DO");
+    currentenv->loop_stack_top--;
+    VM_NEXT;
+
+VM_CASE(OP_I):
+    if (currentenv->loop_stack_top <= 0) {
+        vm_throw(THROW_ABORT, "I: No loop");
     }
-    break;
-case OP_PLUS_LOOP:
-    if (stack->top < 0 || currentenv->return_stack.top < 2) {
-        set_error("+LOOP: Stack or return stack underflow");
-        break;
-    }
-    pop(stack, *a); // Pas
-    mpz_t *index = &currentenv->return_stack.data[currentenv->return_stack.top - 1]; // Prendre l'adresse
-    mpz_t *limit = &currentenv->return_stack.data[currentenv->return_stack.top - 2]; // Prendre l'adresse
-    mpz_add(*index, *index, *a); // index += pas
-    if (mpz_sgn(*a) >= 0) {
-        if (mpz_cmp(*index, *limit) < 0) {
-            *ip = instr.operand - 1; // Retour à DO
-        } else {
-            currentenv->return_stack.top -= 3;
-        }
+    push(stack, &currentenv->loop_stack[currentenv->loop_stack_top - 1].index);
+    VM_NEXT;
+VM_UNCHECKED(OP_I) // Place réservée à l’entrée du mot : seule la boucle reste à contrôler
+    if (currentenv->loop_stack_top <= 0) {
+        vm_throw(THROW_ABORT, "I: No loop");
+    }
+    cell_set(&stack->data[++stack->top], &currentenv->loop_stack[currentenv->loop_stack_top - 1].index);
+    VM_NEXT;
+
+VM_CASE(OP_J):
+    if (currentenv->loop_stack_top >= 2) {
+        push(stack, &currentenv->loop_stack[currentenv->loop_stack_top - 2].index);
+    } else if (currentenv->loop_stack_top == 1) {
+        // Boucle externe seule : lit l’indice courant
+        push(stack, &currentenv->loop_stack[0].index);
     } else {
-        if (mpz_cmp(*index, *limit) > 0) {
-            *ip = instr.operand - 1; // Retour à DO
+        vm_throw(THROW_ABORT, "J: No outer loop");
+    }
+    VM_NEXT;
+VM_CASE(OP_UNLOOP):
+    if (currentenv->loop_stack_top > 0) currentenv->loop_stack_top--;
+    else vm_throw(THROW_ABORT, "UNLOOP without DO");
+    VM_NEXT;
+VM_CASE(OP_LEAVE): // Sortie de boucle : l’opérande pointe après LOOP / +LOOP
+    if (currentenv->loop_stack_top <= 0) {
+        vm_throw(THROW_ABORT, "LEAVE without DO");
+    }
+    currentenv->loop_stack_top--;
+    VM_JUMP(instr->operand);
+VM_CASE(OP_PLUS_LOOP):
+    if (stack->top < 0 || currentenv->loop_stack_top <= 0) {
+        vm_throw(THROW_STACK_UNDERFLOW, "+LOOP: Stack or loop stack underflow");
+    }
+    loop = &currentenv->loop_stack[currentenv->loop_stack_top - 1];
+    x = &stack->data[stack->top--]; // Pas
+    {
+        long int next;
+        if (loop->index.tag == CELL_SMALL && loop->limit.tag == CELL_SMALL && x->tag == CELL_SMALL &&
+            !__builtin_add_overflow(loop->index.small, x->small, &next)) {
+            loop->index.small = next;
+            if (x->small >= 0 ? next < loop->limit.small : next > loop->limit.small) VM_JUMP(instr->operand);
         } else {
-            currentenv->return_stack.top -= 3;
+            int up = cell_sgn(x) >= 0;
+            cell_add(&loop->index, &loop->index, x); // index += pas
+            if (up ? cell_cmp(&loop->index, &loop->limit) < 0 : cell_cmp(&loop->index, &loop->limit) > 0) {
+                VM_JUMP(instr->operand); // Retour à DO
+            }
         }
     }
-    break;
-        case OP_SQRT:
-            pop(stack, *a);
-            if (mpz_cmp_ui(*a, 0) < 0) {
-                set_error("Square root of negative number");
-                push(stack, *a);
+    currentenv->loop_stack_top--;
+    VM_NEXT;
+        VM_CASE(OP_SQRT):
+            pop(stack, a);
+            if (cell_sgn(a) < 0) {
+                push(stack, a);
+                vm_throw(THROW_ABORT, "Square root of negative number");
             } else {
-                mpz_sqrt(*result, *a);
-                push(stack, *result);
+                mpz_sqrt(mpz_pool[2], cell_mpz(a, mpz_pool[0]));
+                push_mpz(stack, mpz_pool[2]);
             }
-        break ; 
+        VM_NEXT; 
         /* 
 case OP_DOT_QUOTE:
     if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
@@ -1706,145 +3433,192 @@ case OP_DOT_QUOTE:
     }
     break;
     */ 
-    case OP_DOT_QUOTE:
-    if (instr.operand < word->string_count && word->strings[instr.operand]) {
-        size_t len = strlen(word->strings[instr.operand]);
+    VM_CASE(OP_DOT_QUOTE):
+    if (instr->operand < word->string_count && word->strings[instr->operand]) {
+        size_t len = strlen(word->strings[instr->operand]);
         if (currentenv->buffer_pos + len < BUFFER_SIZE - 1) {
-            strncpy(currentenv->output_buffer + currentenv->buffer_pos, word->strings[instr.operand], len);
+            strncpy(currentenv->output_buffer + currentenv->buffer_pos, word->strings[instr->operand], len);
             currentenv->buffer_pos += len;
             currentenv->output_buffer[currentenv->buffer_pos] = '\0';
         } else {
-            set_error("DOT_QUOTE: Output buffer overflow");
+            vm_throw(THROW_ABORT, "DOT_QUOTE: Output buffer overflow");
         }
     } else {
-        set_error("DOT_QUOTE: Invalid string index");
-    }
-    break;
-case OP_LITSTRING:
-    if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
-        if (currentenv->buffer_pos + strlen(word->strings[instr.operand]) < BUFFER_SIZE) {
-            strcpy(currentenv->output_buffer + currentenv->buffer_pos, word->strings[instr.operand]);
-            currentenv->buffer_pos += strlen(word->strings[instr.operand]);
+        vm_throw(THROW_ABORT, "DOT_QUOTE: Invalid string index");
+    }
+    VM_NEXT;
+VM_CASE(OP_LITSTRING):
+    if (instr->operand >= 0 && instr->operand < word->string_count && word->strings[instr->operand]) {
+        if (currentenv->buffer_pos + strlen(word->strings[instr->operand]) < BUFFER_SIZE) {
+            strcpy(currentenv->output_buffer + currentenv->buffer_pos, word->strings[instr->operand]);
+            currentenv->buffer_pos += strlen(word->strings[instr->operand]);
             currentenv->output_buffer[currentenv->buffer_pos] = '\0';
         } else {
-            set_error("Output buffer overflow in LITSTRING");
+            vm_throw(THROW_ABORT, "Output buffer overflow in LITSTRING");
         }
     } else {
-        set_error("Invalid string in LITSTRING");
-    }
-    break;
-        case OP_CASE:
-            if (currentenv->control_stack_top < CONTROL_STACK_SIZE) {
-                currentenv->control_stack[currentenv->control_stack_top].type = CT_CASE;
-                currentenv->control_stack[currentenv->control_stack_top].addr = *ip;
-                currentenv->control_stack_top++;
-            } else set_error("Control stack overflow");
-            break;
-        case OP_OF:
-            pop(stack, *a);
-            pop(stack, *b);
-            if (mpz_cmp(*a, *b) != 0) {
-                *ip = instr.operand - 1; // Sauter à ENDOF
-                push(stack, *b); // Remettre la valeur de test
+        vm_throw(THROW_ABORT, "Invalid string in LITSTRING");
+    }
+    VM_NEXT;
+        // BEGIN et CASE sont résolus à la compilation : optimizeCode retire leurs marqueurs,
+        // qui ne s’exécutent que si le mot n’a pas pu être finalisé
+        VM_CASE(OP_CASE):
+            VM_NEXT;
+        VM_CASE(OP_CASE_DISPATCH): // Sélecteur laissé sur la pile, comme après OF
+            if (instr->operand < 0 || instr->operand >= word->case_table_count) {
+                vm_throw(THROW_ABORT, "Invalid CASE table");
+            }
+            if (stack->top < 0) stack_underflow();
+            VM_JUMP(caseTarget(&word->case_tables[instr->operand], &stack->data[stack->top]));
+        VM_CASE(OP_OF):
+            pop(stack, a);
+            pop(stack, b);
+            push(stack, b); // Remettre la valeur de test
+            if (cell_cmp(a, b) != 0) VM_JUMP(instr->operand); // Sauter à ENDOF
+            VM_NEXT;
+        VM_CASE(OP_ENDOF):
+            VM_JUMP(instr->operand); // Sauter à ENDCASE ou prochain ENDOF
+        VM_CASE(OP_ENDCASE):
+            pop(stack, a); // Dépiler la valeur de test
+            VM_NEXT;
+        VM_CASE(OP_EXIT):
+            goto vm_return;
+VM_CASE(OP_BEGIN):
+    VM_NEXT;
+VM_CASE(OP_WHILE):
+    if (stack->top < 0) stack_underflow();
+VM_UNCHECKED(OP_WHILE)
+    if (cell_sgn(&stack->data[stack->top--]) == 0) VM_JUMP(instr->operand); // Sauter si faux
+    VM_NEXT;
+VM_CASE(OP_REPEAT):
+    VM_JUMP(instr->operand); // Toujours sauter à BEGIN
+        VM_CASE(OP_UNTIL):
+            if (stack->top < 0) stack_underflow();
+        VM_UNCHECKED(OP_UNTIL)
+            if (cell_sgn(&stack->data[stack->top--]) == 0) VM_JUMP(instr->operand);
+            VM_NEXT;
+        VM_CASE(OP_AGAIN):
+            VM_JUMP(instr->operand);
+        VM_CASE(OP_BIT_AND):
+            if (stack->top < 1) stack_underflow();
+            x = &stack->data[--stack->top]; y = x + 1;
+            if (x->tag == CELL_SMALL && y->tag == CELL_SMALL) {
+                x->small &= y->small; // Complément à deux, comme GMP
             } else {
-                push(stack, *b); // Remettre la valeur de test
+                mpz_srcptr zx = cell_mpz(x, mpz_pool[0]), zy = cell_mpz(y, mpz_pool[1]);
+                cell_ensure_z(x);
+                mpz_and(x->z, zx, zy);
+                x->tag = CELL_BIG;
+                cell_normalize(x);
             }
-            break;
-        case OP_ENDOF:
-            *ip = instr.operand - 1; // Sauter à ENDCASE ou prochain ENDOF
-            break;
-        case OP_ENDCASE:
-            pop(stack, *a); // Dépiler la valeur de test
-            if (currentenv->control_stack_top > 0 && currentenv->control_stack[currentenv->control_stack_top - 1].type == CT_CASE) {
-                currentenv->control_stack_top--;
-            } else set_error("ENDCASE without CASE");
-            break;
-        case OP_EXIT:
-            *ip = word->code_length;
-            break;
-case OP_BEGIN:
-    if (currentenv->control_stack_top < CONTROL_STACK_SIZE) {
-        currentenv->control_stack[currentenv->control_stack_top++] = (ControlEntry){CT_BEGIN, *ip};
-    } else set_error("Control stack overflow");
-    break;
-case OP_WHILE:
-    pop(stack, *a);
-    if (!currentenv->error_flag && mpz_cmp_ui(*a, 0) == 0) *ip = instr.operand - 1; // Sauter si faux
-    break;
-case OP_REPEAT:
-    *ip = instr.operand - 1; // Toujours sauter à BEGIN, pas besoin de vérifier control_stack ici
-    break;
-        case OP_UNTIL:
-            pop(stack, *a);
-            if (mpz_cmp_ui(*a, 0) == 0) *ip = instr.operand - 1;
-            break;
-        case OP_AGAIN:
-            *ip = instr.operand - 1;
-            break;
-        case OP_BIT_AND:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_and(*result, *a, *b);
-            push(stack, *result);
-            break;
-        case OP_BIT_OR:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_ior(*result, *a, *b);
-            push(stack, *result);
-            break;
-        case OP_BIT_XOR:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_xor(*result, *a, *b);
-            push(stack, *result);
-            break;
-        case OP_BIT_NOT:
-            pop(stack, *a);
-            mpz_com(*result, *a);
-            push(stack, *result);
-            break;
-        case OP_LSHIFT:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_mul_2exp(*result, *a, mpz_get_ui(*b));
-            push(stack, *result);
-            break;
-        case OP_RSHIFT:
-            pop(stack, *b);
-            pop(stack, *a);
-            mpz_fdiv_q_2exp(*result, *a, mpz_get_ui(*b));
-            push(stack, *result);
-            break;
-case OP_FORGET:
-    if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
-        char *word_to_forget = word->strings[instr.operand];
+            VM_NEXT;
+        VM_CASE(OP_BIT_OR):
+            if (stack->top < 1) stack_underflow();
+            x = &stack->data[--stack->top]; y = x + 1;
+            if (x->tag == CELL_SMALL && y->tag == CELL_SMALL) {
+                x->small |= y->small; // Complément à deux, comme GMP
+            } else {
+                mpz_srcptr zx = cell_mpz(x, mpz_pool[0]), zy = cell_mpz(y, mpz_pool[1]);
+                cell_ensure_z(x);
+                mpz_ior(x->z, zx, zy);
+                x->tag = CELL_BIG;
+                cell_normalize(x);
+            }
+            VM_NEXT;
+        VM_CASE(OP_BIT_XOR):
+            if (stack->top < 1) stack_underflow();
+            x = &stack->data[--stack->top]; y = x + 1;
+            if (x->tag == CELL_SMALL && y->tag == CELL_SMALL) {
+                x->small ^= y->small; // Complément à deux, comme GMP
+            } else {
+                mpz_srcptr zx = cell_mpz(x, mpz_pool[0]), zy = cell_mpz(y, mpz_pool[1]);
+                cell_ensure_z(x);
+                mpz_xor(x->z, zx, zy);
+                x->tag = CELL_BIG;
+                cell_normalize(x);
+            }
+            VM_NEXT;
+        VM_CASE(OP_BIT_NOT):
+            if (stack->top < 0) stack_underflow();
+            if ((x = &stack->data[stack->top])->tag == CELL_SMALL) {
+                x->small = ~x->small;
+            } else {
+                mpz_com(x->z, x->z);
+                cell_normalize(x);
+            }
+            VM_NEXT;
+        VM_CASE(OP_LSHIFT):
+            if (stack->top < 1) stack_underflow();
+            x = &stack->data[--stack->top]; y = x + 1;
+            {
+                unsigned long shift = cell_get_ui(y);
+                if (x->tag == CELL_SMALL && shift < 63 &&
+                    x->small <= (LONG_MAX >> shift) && x->small >= (LONG_MIN >> shift)) {
+                    x->small = (long int)((unsigned long)x->small << shift);
+                } else if (shift / 8 > currentenv->gmp->quota) {
+                    // Résultat plus grand que tout le quota : refusé avant d’allouer
+                    stack->top++;
+                    vm_throw(THROW_ABORT, "LSHIFT: Result exceeds memory quota");
+                } else {
+                    mpz_srcptr zx = cell_mpz(x, mpz_pool[0]);
+                    cell_ensure_z(x);
+                    mpz_mul_2exp(x->z, zx, shift);
+                    x->tag = CELL_BIG;
+                    cell_normalize(x);
+                }
+            }
+            VM_NEXT;
+        VM_CASE(OP_RSHIFT):
+            if (stack->top < 1) stack_underflow();
+            x = &stack->data[--stack->top]; y = x + 1;
+            {
+                unsigned long shift = cell_get_ui(y);
+                if (x->tag == CELL_SMALL) { // Décalage arithmétique = arrondi vers -inf
+                    x->small = shift < 64 ? x->small >> shift : (x->small < 0 ? -1 : 0);
+                } else {
+                    mpz_fdiv_q_2exp(x->z, x->z, shift);
+                    cell_normalize(x);
+                }
+            }
+            VM_NEXT;
+VM_CASE(OP_FORGET):
+    if (instr->operand >= 0 && instr->operand < word->string_count && word->strings[instr->operand]) {
+        char *word_to_forget = word->strings[instr->operand];
         int forget_idx = findCompiledWordIndex(word_to_forget);
-        if (forget_idx >= 0) {
+        if (forget_idx >= 0 && forget_idx < currentenv->dictionary.base) {
+            char msg[512];
+            snprintf(msg, sizeof(msg), "FORGET: Cannot forget builtin word: %s", word_to_forget);
+            vm_throw(THROW_ABORT, msg);
+        } else if (forget_idx >= 0) {
             for (int i = forget_idx; i < currentenv->dictionary.count; i++) {
-                CompiledWord *dict_word = &currentenv->dictionary.words[i];
+                CompiledWord *dict_word = dictWord(&currentenv->dictionary, i);
                 if (dict_word->code_length == 1 && dict_word->code[0].opcode == OP_PUSH) {
                     unsigned long encoded_idx = dict_word->code[0].operand;
                     unsigned long type = memory_get_type(encoded_idx);
-                    if (type == TYPE_VAR || type == TYPE_STRING || type == TYPE_ARRAY) {
-                        memory_free(&currentenv->memory_list, dict_word->name);
+                    MemoryNode *mem = memory_get(&currentenv->memory_list, encoded_idx);
+                    // Libération directe par handle, seulement s’il désigne bien ce mot
+                    if ((type == TYPE_VAR || type == TYPE_STRING || type == TYPE_ARRAY) &&
+                        mem && dict_word->name && strcmp(mem->name, dict_word->name) == 0) {
+                        memory_free_handle(&currentenv->memory_list, encoded_idx);
                     }
                 }
                 if (dict_word->name) {
-                    free(dict_word->name);
+                    arena_free_str(&currentenv->arena, dict_word->name);
                     dict_word->name = NULL;
                 }
                 for (int j = 0; j < dict_word->string_count; j++) {
                     if (dict_word->strings[j]) {
-                        free(dict_word->strings[j]);
+                        fstr_release(&currentenv->arena, dict_word->strings[j]);
                         dict_word->strings[j] = NULL;
                     }
                 }
-                dict_word->code_length = 0;
-                dict_word->string_count = 0;
+                freeWordCode(dict_word);
+                freeWordBody(dict_word, &currentenv->arena);
             }
             long int old_dict_count = currentenv->dictionary.count;
             currentenv->dictionary.count = forget_idx;
+            dictIndexRebuild(&currentenv->dictionary);
+            reverifyCallers(&currentenv->dictionary, NULL); // Appels restés vers les mots oubliés
             char msg[512];
             snprintf(msg, sizeof(msg), "Forgot everything from '%s' at index %d (dict was %ld, now %ld; mem count now %lu)", 
                      word_to_forget, forget_idx, old_dict_count, currentenv->dictionary.count, currentenv->memory_list.count);
@@ -1852,96 +3626,91 @@ case OP_FORGET:
         } else {
             char msg[512];
             snprintf(msg, sizeof(msg), "FORGET: Unknown word: %s", word_to_forget);
-            set_error(msg);
+            vm_throw(THROW_ABORT, msg);
         }
     } else {
-        set_error("FORGET: Invalid word name");
+        vm_throw(THROW_ABORT, "FORGET: Invalid word name");
     }
-    break;
-case OP_WORDS:
+    VM_NEXT;
+VM_CASE(OP_WORDS):
     if (currentenv->dictionary.count > 0) {
         char words_msg[2048] = "";
         size_t remaining = sizeof(words_msg) - 1;
         for (int i = 0; i < currentenv->dictionary.count && remaining > 1; i++) {
-            if (currentenv->dictionary.words[i].name) {
-                size_t name_len = strlen(currentenv->dictionary.words[i].name);
+            // Builtin redéfini : seul le mot propre est listé, à sa place
+            if (i < currentenv->dictionary.base &&
+                dictLookup(&currentenv->dictionary, dictWord(&currentenv->dictionary, i)->name) != i) continue;
+            if (dictWord(&currentenv->dictionary, i)->name) {
+                size_t name_len = strlen(dictWord(&currentenv->dictionary, i)->name);
                 if (name_len + 1 < remaining) {
-                    strncat(words_msg, currentenv->dictionary.words[i].name, remaining);
+                    strncat(words_msg, dictWord(&currentenv->dictionary, i)->name, remaining);
                     strncat(words_msg, " ", remaining - name_len);
                     remaining -= (name_len + 1);
                 } else {
                     send_to_channel("WORDS truncated: buffer full");
-                    break;
+                    VM_NEXT;
                 }
             } else {
-                set_error("WORDS: Null name in dictionary");
-                break;
+                vm_throw(THROW_ABORT, "WORDS: Null name in dictionary");
             }
         }
         send_to_channel(words_msg);
     } else {
         send_to_channel("Dictionary empty");
     }
-    break;
+    VM_NEXT;
     
-case OP_LOAD: {
+VM_CASE(OP_LOAD): {
     char *filename = NULL;
-    if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
-        filename = strdup(word->strings[instr.operand]);
+    if (instr->operand >= 0 && instr->operand < word->string_count && word->strings[instr->operand]) {
+        filename = strdup(word->strings[instr->operand]);
     } else {
-        set_error("LOAD: No filename provided");
-        break;
+        vm_throw(THROW_ABORT, "LOAD: No filename provided");
     }
 
     FILE *file = fopen(filename, "r");
-    if (file) {
-        char buffer[512];
-        while (fgets(buffer, sizeof(buffer), file)) {
-            buffer[strcspn(buffer, "\n")] = '\0';
-            interpret(buffer, stack); // Utiliser la pile passée (stack, pas forcément main_stack)
-        }
-        fclose(file);
-    } else {
+    if (!file) {
         snprintf(temp_str, sizeof(temp_str), "LOAD: Cannot open file '%s'", filename);
-        set_error(temp_str);
+        free(filename);
+        vm_throw(THROW_ABORT, temp_str);
     }
     free(filename);
-    break;
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), file)) {
+        buffer[strcspn(buffer, "\n")] = '\0';
+        interpret(buffer, stack); // Utiliser la pile passée (stack, pas forcément main_stack)
+    }
+    fclose(file);
+    // Chaque ligne est interprétée à part : seule l’erreur de la dernière arrête l’appelant
+    VM_SAFEPOINT();
+    VM_NEXT;
 }
  
-        case OP_PICK:
-            pop(stack, *a);
-            int n = mpz_get_si(*a);
-            if (stack->top >= n) push(stack, stack->data[stack->top - n]);
-            else set_error("PICK: Stack underflow");
-            break;
-        case OP_ROLL:
-            pop(stack, *a);
-            int zozo = mpz_get_si(*a);
-            if (stack->top >= zozo) {
-                mpz_t temp[zozo + 1];
-                for (int i = 0; i <= zozo; i++) {
-                    mpz_init(temp[i]);
-                    pop(stack, temp[i]);
-                }
-                for (int i = zozo - 1; i >= 0; i--) push(stack, temp[i]);
-                mpz_clear(temp[zozo]);
-                for (int i = 0; i < zozo; i++) mpz_clear(temp[i]);
-            } else set_error("ROLL: Stack underflow");
-            break;
-case OP_PLUSSTORE:
+        VM_CASE(OP_PICK):
+            pop(stack, a);
+            int n = cell_get_si(a);
+            if (n >= 0 && stack->top >= n) push(stack, &stack->data[stack->top - n]);
+            else vm_throw(THROW_STACK_UNDERFLOW, "PICK: Stack underflow");
+            VM_NEXT;
+        VM_CASE(OP_ROLL):
+            pop(stack, a);
+            int zozo = cell_get_si(a);
+            if (zozo >= 0 && stack->top >= zozo) {
+                // La cellule de rang zozo remonte au sommet, les autres descendent d’un cran
+                for (int i = stack->top - zozo; i < stack->top; i++) cell_swap(&stack->data[i], &stack->data[i + 1]);
+            } else vm_throw(THROW_STACK_UNDERFLOW, "ROLL: Stack underflow");
+            VM_NEXT;
+VM_CASE(OP_PLUSSTORE):
     if (stack->top < 1) {
-        set_error("+!: Stack underflow");
-        break;
+        vm_throw(THROW_STACK_UNDERFLOW, "+!: Stack underflow");
     }
-    pop(stack, *a); // encoded_idx (ex. 268435456 pour ZOZO)
+    pop(stack, a); // encoded_idx (ex. 268435456 pour ZOZO)
     if (stack->top < 0) {
-        set_error("+!: Stack underflow for value");
-        push(stack, *a);
-        break;
+        push(stack, a);
+        vm_throw(THROW_STACK_UNDERFLOW, "+!: Stack underflow for value");
     }
-    pop(stack, *b); // offset ou valeur (selon type)
-    unsigned long encoded_idx = mpz_get_ui(*a);
+    pop(stack, b); // offset ou valeur (selon type)
+    unsigned long encoded_idx = cell_get_ui(a);
     // char debug_msg[512];
     /* snprintf(debug_msg, sizeof(debug_msg), "+!: encoded_idx=%lu", encoded_idx);
     send_to_channel(debug_msg);
@@ -1949,15 +3718,14 @@ case OP_PLUSSTORE:
     MemoryNode *node = memory_get(&currentenv->memory_list, encoded_idx);
     if (!node) {
         snprintf(debug_msg, sizeof(debug_msg), "+!: Invalid memory index %lu", encoded_idx);
-        set_error(debug_msg);
-        push(stack, *b);
-        push(stack, *a);
-        break;
+        push(stack, b);
+        push(stack, a);
+        vm_throw(THROW_ABORT, debug_msg);
     }
 
     if (node->type == TYPE_VAR) {
         // Cas variable : *b est la valeur à ajouter
-        mpz_add(node->value.number, node->value.number, *b);
+        cell_add(&node->value.number, &node->value.number, b);
         /* snprintf(debug_msg, sizeof(debug_msg), "+!: Added %s to %s, now %s", 
                  mpz_get_str(NULL, 10, *b), node->name, mpz_get_str(NULL, 10, node->value.number));
         send_to_channel(debug_msg);
@@ -1965,29 +3733,32 @@ case OP_PLUSSTORE:
     } else if (node->type == TYPE_ARRAY) {
         // Cas tableau : vérifier s'il y a un offset sur la pile
         if (node->value.array.size == 0) {
-        set_error("tableau vide");
-        push(stack, *a);
-        push(stack, *b);
-        break;
+        push(stack, a);
+        push(stack, b);
+        vm_throw(THROW_ABORT, "tableau vide");
     }
         if (stack->top < 0) {
             // Pas d'offset : *b est la valeur, ajout à l'index 0
             if (node->value.array.size > 0) {
-                mpz_add(node->value.array.data[0], node->value.array.data[0], *b);
+                if (!array_add(node, 0, b)) vm_throw(THROW_ABORT, "+!: Memory allocation failed");
+                memory_array_fetch(node, 0, result);
+                char *added = cell_get_str(b), *now = cell_get_str(result);
                 snprintf(debug_msg, sizeof(debug_msg), "+!: Added %s to %s[0], now %s", 
-                         mpz_get_str(NULL, 10, *b), node->name, mpz_get_str(NULL, 10, node->value.array.data[0]));
+                         added, node->name, now);
                 send_to_channel(debug_msg);
+                free(added);
+                free(now);
             } else {
-                set_error("+!: Array is empty");
-                push(stack, *b);
-                push(stack, *a);
+                push(stack, b);
+                push(stack, a);
+                vm_throw(THROW_ABORT, "+!: Array is empty");
             }
         } else {
             // Offset présent : dépiler la valeur, *b est l'offset
-            pop(stack, *result); // valeur à ajouter
-            unsigned long offset = mpz_get_ui(*b); // *b est l'offset
+            pop(stack, result); // valeur à ajouter
+            unsigned long offset = cell_get_ui(b); // *b est l'offset
             if (offset < node->value.array.size) {
-                mpz_add(node->value.array.data[offset], node->value.array.data[offset], *result);
+                if (!array_add(node, offset, result)) vm_throw(THROW_ABORT, "+!: Memory allocation failed");
                 /*snprintf(debug_msg, sizeof(debug_msg), "+!: Added %s to %s[%lu], now %s", 
                          mpz_get_str(NULL, 10, *result), node->name, offset, 
                          mpz_get_str(NULL, 10, node->value.array.data[offset]));
@@ -1996,122 +3767,108 @@ case OP_PLUSSTORE:
             } else {
                 snprintf(debug_msg, sizeof(debug_msg), "+!: Offset %lu out of bounds (size=%lu)", 
                          offset, node->value.array.size);
-                set_error(debug_msg);
-                push(stack, *result); // Remettre valeur
-                push(stack, *b);      // Remettre offset
-                push(stack, *a);      // Remettre encoded_idx
+                push(stack, result); // Remettre valeur
+                push(stack, b);      // Remettre offset
+                push(stack, a);      // Remettre encoded_idx
+                vm_throw(THROW_ABORT, debug_msg);
             }
         }
     } else {
-        set_error("+!: Not a variable or array");
-        push(stack, *b);
-        push(stack, *a);
-    }
-    break;
-        case OP_DEPTH:
-            mpz_set_si(*result, stack->top + 1);
-            push(stack, *result);
-            break;
-        case OP_TOP:
-            if (stack->top >= 0) push(stack, stack->data[stack->top]);
-            else set_error("TOP: Stack underflow");
-            break;
-        case OP_NIP:
-            if (stack->top >= 1) {
-                pop(stack, *a);
-                pop(stack, *b);
-                push(stack, *a);
-            } else set_error("NIP: Stack underflow");
-            break;
-
-case OP_CREATE:
-    if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
-        char *name = word->strings[instr.operand];
+        push(stack, b);
+        push(stack, a);
+        vm_throw(THROW_ABORT, "+!: Not a variable or array");
+    }
+    VM_NEXT;
+        VM_CASE(OP_DEPTH):
+            push_si(stack, stack->top + 1);
+            VM_NEXT;
+        VM_CASE(OP_TOP):
+            if (stack->top >= 0) push(stack, &stack->data[stack->top]);
+            else vm_throw(THROW_STACK_UNDERFLOW, "TOP: Stack underflow");
+            VM_NEXT;
+        VM_CASE(OP_NIP):
+            if (stack->top < 1) vm_throw(THROW_STACK_UNDERFLOW, "NIP: Stack underflow");
+        VM_UNCHECKED(OP_NIP)
+            cell_swap(&stack->data[stack->top - 1], &stack->data[stack->top]);
+            stack->top--;
+            VM_NEXT;
+
+VM_CASE(OP_CREATE):
+    if (instr->operand >= 0 && instr->operand < word->string_count && word->strings[instr->operand]) {
+        char *name = word->strings[instr->operand];
         if (findCompiledWordIndex(name) >= 0) {
             char msg[512];
             snprintf(msg, sizeof(msg), "CREATE: '%s' already defined", name);
-            set_error(msg);
+            vm_throw(THROW_ABORT, msg);
         } else {
             unsigned long index = memory_create(&currentenv->memory_list, name, TYPE_ARRAY);
             if (index == 0) {
-                set_error("CREATE: Memory creation failed");
+                vm_throw(THROW_ABORT, "CREATE: Memory creation failed");
             } else if (currentenv->dictionary.count < currentenv->dictionary.capacity) {
                 int dict_idx = currentenv->dictionary.count++;
-                currentenv->dictionary.words[dict_idx].name = strdup(name);
-                currentenv->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-                currentenv->dictionary.words[dict_idx].code[0].operand = index;
-                currentenv->dictionary.words[dict_idx].code_length = 1;
-                currentenv->dictionary.words[dict_idx].string_count = 0;
+                dictWord(&currentenv->dictionary, dict_idx)->name = arena_strdup(&currentenv->arena, name);
+                dictIndexAdd(&currentenv->dictionary, dict_idx);
+                setWordInstruction(&currentenv->dictionary, dictWord(&currentenv->dictionary, dict_idx), OP_PUSH, index);
+                dictWord(&currentenv->dictionary, dict_idx)->string_count = 0;
                 MemoryNode *node = memory_get(&currentenv->memory_list, index);
                 if (node && node->type == TYPE_ARRAY) {
-                    node->value.array.data = (mpz_t *)malloc(sizeof(mpz_t));
-                    mpz_init(node->value.array.data[0]);
-                    mpz_set_ui(node->value.array.data[0], 0);
-                    node->value.array.size = 1;
+                    memory_array_resize(node, 1); // Tableau compact d’un élément
                 }
             } else {
                 resizeDynamicDictionary(&currentenv->dictionary);
                 int dict_idx = currentenv->dictionary.count++;
-                currentenv->dictionary.words[dict_idx].name = strdup(name);
-                currentenv->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-                currentenv->dictionary.words[dict_idx].code[0].operand = index;
-                currentenv->dictionary.words[dict_idx].code_length = 1;
-                currentenv->dictionary.words[dict_idx].string_count = 0;
+                dictWord(&currentenv->dictionary, dict_idx)->name = arena_strdup(&currentenv->arena, name);
+                dictIndexAdd(&currentenv->dictionary, dict_idx);
+                setWordInstruction(&currentenv->dictionary, dictWord(&currentenv->dictionary, dict_idx), OP_PUSH, index);
+                dictWord(&currentenv->dictionary, dict_idx)->string_count = 0;
                 MemoryNode *node = memory_get(&currentenv->memory_list, index);
                 if (node && node->type == TYPE_ARRAY) {
-                    node->value.array.data = (mpz_t *)malloc(sizeof(mpz_t));
-                    mpz_init(node->value.array.data[0]);
-                    mpz_set_ui(node->value.array.data[0], 0);
-                    node->value.array.size = 1;
+                    memory_array_resize(node, 1); // Tableau compact d’un élément
                 }
             }
         }
     } else {
-        set_error("CREATE: Invalid name");
+        vm_throw(THROW_ABORT, "CREATE: Invalid name");
     }
-    break;
-case OP_STRING:
-    if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
-        char *name = word->strings[instr.operand];
+    VM_NEXT;
+VM_CASE(OP_STRING):
+    if (instr->operand >= 0 && instr->operand < word->string_count && word->strings[instr->operand]) {
+        char *name = word->strings[instr->operand];
         if (findCompiledWordIndex(name) >= 0) {
             char msg[512];
             snprintf(msg, sizeof(msg), "STRING: '%s' already defined", name);
-            set_error(msg);
+            vm_throw(THROW_ABORT, msg);
         } else {
             unsigned long index = memory_create(&currentenv->memory_list, name, TYPE_STRING);
             if (index == 0) {
-                set_error("STRING: Memory creation failed");
+                vm_throw(THROW_ABORT, "STRING: Memory creation failed");
             } else if (currentenv->dictionary.count < currentenv->dictionary.capacity) {
                 int dict_idx = currentenv->dictionary.count++;
-                currentenv->dictionary.words[dict_idx].name = strdup(name);
-                currentenv->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-                currentenv->dictionary.words[dict_idx].code[0].operand = index;
-                currentenv->dictionary.words[dict_idx].code_length = 1;
-                currentenv->dictionary.words[dict_idx].string_count = 0;
+                dictWord(&currentenv->dictionary, dict_idx)->name = arena_strdup(&currentenv->arena, name);
+                dictIndexAdd(&currentenv->dictionary, dict_idx);
+                setWordInstruction(&currentenv->dictionary, dictWord(&currentenv->dictionary, dict_idx), OP_PUSH, index);
+                dictWord(&currentenv->dictionary, dict_idx)->string_count = 0;
             } else {
                 resizeDynamicDictionary(&currentenv->dictionary);
                 int dict_idx = currentenv->dictionary.count++;
-                currentenv->dictionary.words[dict_idx].name = strdup(name);
-                currentenv->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-                currentenv->dictionary.words[dict_idx].code[0].operand = index;
-                currentenv->dictionary.words[dict_idx].code_length = 1;
-                currentenv->dictionary.words[dict_idx].string_count = 0;
+                dictWord(&currentenv->dictionary, dict_idx)->name = arena_strdup(&currentenv->arena, name);
+                dictIndexAdd(&currentenv->dictionary, dict_idx);
+                setWordInstruction(&currentenv->dictionary, dictWord(&currentenv->dictionary, dict_idx), OP_PUSH, index);
+                dictWord(&currentenv->dictionary, dict_idx)->string_count = 0;
             }
         }
     } else {
-        set_error("STRING: Invalid name");
+        vm_throw(THROW_ABORT, "STRING: Invalid name");
     }
-    break;
-case OP_QUOTE:
-    if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
-        char *str = word->strings[instr.operand]; // Pas besoin de dupliquer ici, déjà alloué
-        push_string(str); // Pousse sur string_stack
-        mpz_set_si(*result, currentenv->string_stack_top); // Index sur la pile principale
-        push(stack, *result);
+    VM_NEXT;
+VM_CASE(OP_QUOTE):
+    if (instr->operand >= 0 && instr->operand < word->string_count && word->strings[instr->operand]) {
+        // Le mot et la pile de chaînes partagent la même chaîne
+        push_string_handle(stack, fstr_ref(word->strings[instr->operand]));
     } else {
-        set_error("QUOTE: Invalid string index");
+        vm_throw(THROW_ABORT, "QUOTE: Invalid string index");
     }
-    break;
+    VM_NEXT;
     /* Ancienne version 
 case OP_PRINT:
     pop(stack, *a);
@@ -2127,134 +3884,441 @@ case OP_PRINT:
     }
     break;
     */ 
-    case OP_PRINT:
-    pop(stack, *a);
-    if (mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) <= currentenv->string_stack_top) {
-        char *str = currentenv->string_stack[mpz_get_si(*a)];
+    VM_CASE(OP_PRINT):
+    pop(stack, a);
+    StringSlot *print_slot = string_slot(a);
+    if (print_slot) {
+        char *str = print_slot->str;
         if (str) {
-            size_t len = strlen(str);
+            size_t len = fstr_len(str);
             if (currentenv->buffer_pos + len < BUFFER_SIZE - 1) {
-                strncpy(currentenv->output_buffer + currentenv->buffer_pos, str, len);
+                memcpy(currentenv->output_buffer + currentenv->buffer_pos, str, len);
                 currentenv->buffer_pos += len;
                 currentenv->output_buffer[currentenv->buffer_pos] = '\0';
             } else {
-                set_error("PRINT: Output buffer overflow");
+                vm_throw(THROW_ABORT, "PRINT: Output buffer overflow");
             }
         } else {
-            set_error("PRINT: No string at index");
+            vm_throw(THROW_ABORT, "PRINT: No string at index");
         }
     } else {
-        set_error("PRINT: Invalid string stack index");
+        vm_throw(THROW_ABORT, "PRINT: Invalid string stack index");
     }
-    break;
-    case OP_NUM_TO_BIN:
-        pop(stack, *a);
-        char *bin_str = mpz_get_str(NULL, 2, *a); // Base 2 = binaire
+    VM_NEXT;
+    VM_CASE(OP_NUM_TO_BIN):
+        pop(stack, a);
+        char *bin_str = mpz_get_str_alloc(2, cell_mpz(a, mpz_pool[0])); // Base 2 = binaire
         send_to_channel(bin_str);
-        free(bin_str); // Libérer la mémoire allouée par mpz_get_str
-        break;
-	case OP_PRIME_TEST:
-        pop(stack, *a);
-        int is_prime = mpz_probab_prime_p(*a, 25); // 25 itérations de Miller-Rabin
-        mpz_set_si(*result, is_prime != 0); // 1 si premier ou probablement premier, 0 sinon
-        push(stack, *result);
-        break;
-		case OP_CLEAR_STACK:
-            stack->top = -1;  // Vide la pile en réinitialisant le sommet
-            break;
-        case OP_CLOCK:
-            mpz_set_si(*result, (long int)time(NULL));
-            push(stack, *result);
-            break;
-case OP_IMAGE:
+        free(bin_str);
+        VM_NEXT;
+	VM_CASE(OP_PRIME_TEST):
+        pop(stack, a);
+        int is_prime = mpz_probab_prime_p(cell_mpz(a, mpz_pool[0]), 25); // 25 itérations de Miller-Rabin
+        push_si(stack, is_prime != 0);
+        VM_NEXT;
+		VM_CASE(OP_CLEAR_STACK):
+            {
+                long int old_top = stack->top;
+                stack->top = -1;  // Vide la pile en réinitialisant le sommet
+                stack_release(stack, old_top);
+            }
+            VM_NEXT;
+        VM_CASE(OP_CLOCK):
+            push_si(stack, (long int)time(NULL));
+            VM_NEXT;
+VM_CASE(OP_IMAGE):
     if (stack->top < 0) {
-        set_error("IMAGE: Stack underflow");
-        break;
+        vm_throw(THROW_STACK_UNDERFLOW, "IMAGE: Stack underflow");
     }
-    pop(stack, *a); // Index de la description dans string_stack
-    if (mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) <= currentenv->string_stack_top) {
-        char *description = currentenv->string_stack[mpz_get_si(*a)];
+    pop(stack, a); // Handle de la description dans la pile de chaînes
+    StringSlot *image_slot = string_slot(a);
+    if (image_slot) {
+        char *description = image_slot->str;
         if (description) {
             char *short_url = generate_image(description);
             if (short_url) {
                 send_to_channel(short_url);
                 free(short_url);
-                // Nettoyer string_stack
-                free(currentenv->string_stack[mpz_get_si(*a)]);
-                for (int i = mpz_get_si(*a); i < currentenv->string_stack_top; i++) {
-                    currentenv->string_stack[i] = currentenv->string_stack[i + 1];
-                }
-                currentenv->string_stack[currentenv->string_stack_top--] = NULL;
+                fstr_release(&currentenv->arena, take_string(image_slot));
             } else {
-                set_error("IMAGE: Failed to generate or upload image");
+                vm_throw(THROW_ABORT, "IMAGE: Failed to generate or upload image");
             }
         } else {
-            set_error("IMAGE: No description string at index");
+            vm_throw(THROW_ABORT, "IMAGE: No description string at index");
         }
     } else {
-        set_error("IMAGE: Invalid string stack index");
-        push(stack, *a);
+        push(stack, a);
+        vm_throw(THROW_ABORT, "IMAGE: Invalid string stack index");
     }
-    break;
-    case OP_TEMP_IMAGE:
+    VM_NEXT;
+    VM_CASE(OP_TEMP_IMAGE):
     if (stack->top < 0) {
-        set_error("IMAGE: Stack underflow");
-        break;
+        vm_throw(THROW_STACK_UNDERFLOW, "IMAGE: Stack underflow");
     }
-    pop(stack, *a); // Index de la description dans string_stack
-    if (mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) <= currentenv->string_stack_top) {
-        char *description = currentenv->string_stack[mpz_get_si(*a)];
+    pop(stack, a); // Handle de la description dans la pile de chaînes
+    StringSlot *tiny_slot = string_slot(a);
+    if (tiny_slot) {
+        char *description = tiny_slot->str;
         if (description) {
             char *short_url = generate_image_tiny(description);
             if (short_url) {
                 send_to_channel(short_url);
                 free(short_url);
-                // Nettoyer string_stack
-                free(currentenv->string_stack[mpz_get_si(*a)]);
-                for (int i = mpz_get_si(*a); i < currentenv->string_stack_top; i++) {
-                    currentenv->string_stack[i] = currentenv->string_stack[i + 1];
-                }
-                currentenv->string_stack[currentenv->string_stack_top--] = NULL;
+                fstr_release(&currentenv->arena, take_string(tiny_slot));
             } else {
-                set_error("IMAGE: Failed to generate or upload image");
+                vm_throw(THROW_ABORT, "IMAGE: Failed to generate or upload image");
             }
         } else {
-            set_error("IMAGE: No description string at index");
+            vm_throw(THROW_ABORT, "IMAGE: No description string at index");
         }
     } else {
-        set_error("IMAGE: Invalid string stack index");
-        push(stack, *a);
+        push(stack, a);
+        vm_throw(THROW_ABORT, "IMAGE: Invalid string stack index");
     }
-    break;
-        	case OP_CLEAR_STRINGS:
+    VM_NEXT;
+        	VM_CASE(OP_CLEAR_STRINGS):
     if (strcmp(word->name, "CLEAR-STRINGS") == 0) {
-        for (int i = 0; i <= currentenv->string_stack_top; i++) {
-            if (currentenv->string_stack[i]) free(currentenv->string_stack[i]);
+        // Les générations avancent : les handles encore sur la pile de données deviennent invalides
+        for (int i = 0; i < currentenv->string_slots_used; i++) {
+            StringSlot *s = &currentenv->string_slots[i];
+            if (s->used) fstr_release(&currentenv->arena, take_string(s));
         }
-        currentenv->string_stack_top = -1;
+        currentenv->string_slots_used = 0;
+        currentenv->string_free_head = -1;
     } else {
         stack->top = -1;
     }
-    break;
-	case OP_DELAY:
+    VM_NEXT;
+	VM_CASE(OP_DELAY):
     if (stack->top >= 0) {
-        mpz_t delay_ms;
-        pop(stack, delay_ms);
-        unsigned long ms = mpz_get_ui(delay_ms);
+        pop(stack, a);
+        unsigned long ms = cell_get_ui(a);
         usleep(ms * 1000); // ms -> microsecondes
     } else {
-        set_error("DELAY: Stack underflow");
+        vm_throw(THROW_STACK_UNDERFLOW, "DELAY: Stack underflow");
+    }
+    VM_NEXT;
+    // Superinstructions : mêmes effets que la séquence d’origine, sans dispatch intermédiaire
+VM_CASE(OP_SQUARE): // DUP *
+    if (stack->top < 0) vm_throw(THROW_STACK_UNDERFLOW, "DUP: Stack underflow");
+VM_UNCHECKED(OP_SQUARE)
+    x = &stack->data[stack->top];
+    cell_mul(x, x, x);
+    VM_NEXT;
+VM_CASE(OP_OVER_ADD): // OVER +
+    if (stack->top < 1) vm_throw(THROW_STACK_UNDERFLOW, "OVER: Stack underflow");
+VM_UNCHECKED(OP_OVER_ADD)
+    x = &stack->data[stack->top];
+    cell_add(x, x - 1, x);
+    VM_NEXT;
+VM_CASE(OP_PUSH_ADD): // n +
+VM_CASE(OP_PUSH_SUB): // n -
+VM_CASE(OP_PUSH_MUL): // n *
+    if (stack->top < 0) { // Même erreur que la séquence d’origine
+        push_si(stack, instr->operand);
+        if (instr->opcode == OP_PUSH_ADD) goto vm_add;
+        if (instr->opcode == OP_PUSH_SUB) goto vm_sub;
+        goto vm_mul;
+    }
+VM_UNCHECKED(OP_PUSH_ADD) // Entrée commune aux trois, comme VM_CASE
+    {
+        Cell *t = &stack->data[stack->top];
+        cell_set_si(b, instr->operand);
+        if (instr->opcode == OP_PUSH_ADD) cell_add(t, t, b);
+        else if (instr->opcode == OP_PUSH_SUB) cell_sub(t, t, b);
+        else cell_mul(t, t, b);
+    }
+    VM_NEXT;
+VM_CASE(OP_EQ_BRANCH_FALSE): // = IF
+    if (stack->top < 1) goto vm_eq; // Même erreur que la séquence d’origine
+VM_UNCHECKED(OP_EQ_BRANCH_FALSE)
+    stack->top -= 2;
+    if (cell_cmp(&stack->data[stack->top + 1], &stack->data[stack->top + 2]) != 0) VM_JUMP(instr->operand);
+    VM_NEXT;
+VM_CASE(OP_LT_BRANCH_FALSE): // < IF
+    if (stack->top < 1) goto vm_lt;
+VM_UNCHECKED(OP_LT_BRANCH_FALSE)
+    stack->top -= 2;
+    if (cell_cmp(&stack->data[stack->top + 1], &stack->data[stack->top + 2]) >= 0) VM_JUMP(instr->operand);
+    VM_NEXT;
+// Tableaux entiers : les opérandes sont des handles de CREATE, remis sur la pile en cas d’erreur
+VM_CASE(OP_FILL): // ( valeur tableau -- )
+    if (stack->top < 1) {
+        vm_throw(THROW_STACK_UNDERFLOW, "FILL: Stack underflow");
+    }
+    pop(stack, a);
+    pop(stack, b);
+    {
+        MemoryNode *node = array_from_cell(a);
+        if (!node) {
+            push(stack, b);
+            push(stack, a);
+            vm_throw(THROW_ABORT, "FILL: Not an array");
+        } else if (!memory_array_fill(node, b)) {
+            vm_throw(THROW_ABORT, "FILL: Memory allocation failed");
+        }
     }
-    break;
+    VM_NEXT;
+VM_CASE(OP_SUM): // ( tableau -- somme )
+    if (stack->top < 0) {
+        vm_throw(THROW_STACK_UNDERFLOW, "SUM: Stack underflow");
+    }
+    pop(stack, a);
+    {
+        MemoryNode *node = array_from_cell(a);
+        if (!node) {
+            push(stack, a);
+            vm_throw(THROW_ABORT, "SUM: Not an array");
+        }
+        memory_array_sum(node, result);
+        push(stack, result);
+    }
+    VM_NEXT;
+VM_CASE(OP_MOVE): // ( source destination -- ) copie min(tailles) éléments
+    if (stack->top < 1) {
+        vm_throw(THROW_STACK_UNDERFLOW, "MOVE: Stack underflow");
+    }
+    pop(stack, b);
+    pop(stack, a);
+    {
+        MemoryNode *src = array_from_cell(a), *dst = array_from_cell(b);
+        if (!src || !dst) {
+            push(stack, a);
+            push(stack, b);
+            vm_throw(THROW_ABORT, "MOVE: Not an array");
+        } else if (!memory_array_move(dst, src)) {
+            vm_throw(THROW_ABORT, "MOVE: Memory allocation failed");
+        }
+    }
+    VM_NEXT;
+VM_CASE(OP_COUNT_IF): // ( valeur tableau -- n ) éléments égaux à valeur
+    if (stack->top < 1) {
+        vm_throw(THROW_STACK_UNDERFLOW, "COUNT-IF: Stack underflow");
+    }
+    pop(stack, a);
+    pop(stack, b);
+    {
+        MemoryNode *node = array_from_cell(a);
+        if (!node) {
+            push(stack, b);
+            push(stack, a);
+            vm_throw(THROW_ABORT, "COUNT-IF: Not an array");
+        }
+        push_si(stack, (long int)memory_array_count(node, b));
+    }
+    VM_NEXT;
+VM_CASE(OP_MAX): // ( tableau -- max )
+    if (stack->top < 0) {
+        vm_throw(THROW_STACK_UNDERFLOW, "MAX: Stack underflow");
+    }
+    pop(stack, a);
+    {
+        MemoryNode *node = array_from_cell(a);
+        if (!node) {
+            push(stack, a);
+            vm_throw(THROW_ABORT, "MAX: Not an array");
+        }
+        if (!memory_array_max(node, result)) {
+            push(stack, a);
+            vm_throw(THROW_ABORT, "MAX: Array is empty");
+        }
+        push(stack, result);
+    }
+    VM_NEXT;
+VM_CASE(OP_DOT_PRODUCT): // ( tableau1 tableau2 -- produit scalaire ) sur min(tailles) éléments
+    if (stack->top < 1) {
+        vm_throw(THROW_STACK_UNDERFLOW, "DOT-PRODUCT: Stack underflow");
+    }
+    pop(stack, b);
+    pop(stack, a);
+    {
+        MemoryNode *x = array_from_cell(a), *y = array_from_cell(b);
+        if (!x || !y) {
+            push(stack, a);
+            push(stack, b);
+            vm_throw(THROW_ABORT, "DOT-PRODUCT: Not an array");
+        }
+        memory_array_dot(x, y, result);
+        push(stack, result);
+    }
+    VM_NEXT;
+VM_CASE(OP_STACK_LIMIT): // ( n -- ) profondeur max des piles de l’utilisateur
+    if (stack->top < 0) {
+        vm_throw(THROW_STACK_UNDERFLOW, "STACK-LIMIT: Stack underflow");
+    }
+    pop(stack, a);
+    {
+        long int n = cell_get_si(a);
+        if (a->tag != CELL_SMALL || n < STACK_INITIAL || n > STACK_LIMIT_MAX) {
+            snprintf(debug_msg, sizeof(debug_msg), "STACK-LIMIT: Limit must be between %d and %d",
+                     STACK_INITIAL, STACK_LIMIT_MAX);
+            push(stack, a);
+            vm_throw(THROW_ABORT, debug_msg);
+        } else if (n <= stack->top || n <= currentenv->return_stack.top || n < currentenv->string_slots_used) {
+            push(stack, a);
+            vm_throw(THROW_ABORT, "STACK-LIMIT: Stacks are deeper than the limit");
+        } else {
+            stack_set_limit(&currentenv->main_stack, n);
+            stack_set_limit(&currentenv->return_stack, n);
+            if (currentenv->string_capacity > n) currentenv->string_capacity = (int)n; // Slots au-delà jamais distribués
+        }
+    }
+    VM_NEXT;
+VM_CASE(OP_I_ARRAY_FETCH): // I <tableau> @
+    if (currentenv->loop_stack_top <= 0) {
+        vm_throw(THROW_ABORT, "I: No loop");
+    }
+    {
+        Cell *index = &currentenv->loop_stack[currentenv->loop_stack_top - 1].index;
+        MemoryNode *array = memory_get(&currentenv->memory_list, instr->operand);
+        if (array && array->type == TYPE_ARRAY && index->tag == CELL_SMALL &&
+            index->small >= 0 && (unsigned long)index->small < array->value.array.size) {
+            if (array->value.array.packed) push_si(stack, array->value.array.packed[index->small]);
+            else push(stack, &array->value.array.data[index->small]);
+            VM_NEXT;
+        }
+        // Hors bornes ou tableau disparu : chemin générique de @ (mêmes messages)
+        push(stack, index);
+        push_si(stack, instr->operand);
+        goto vm_fetch;
+    }
+#ifdef FORTH_THREADED
+    vm_unknown:
+        vm_throw(THROW_ABORT, "Unknown opcode");
+    vm_exit:
+        goto vm_return;
+#else
         default:
-            set_error("Unknown opcode");
-            break;
+            vm_throw(THROW_ABORT, "Unknown opcode");
+#endif
+    }
+vm_return:
+    if (currentenv->frame_top <= frame_base) {
+        currentenv->loop_stack_top = loop_base;
+        goto vm_leave;
+    }
+    {
+        Frame *frame = &currentenv->frames[--currentenv->frame_top];
+        currentenv->loop_stack_top = frame->loop_top; // Boucles quittées par EXIT sans UNLOOP
+        word_index = frame->word_index;
+        // Relire par index : le dictionnaire a pu être réalloué pendant l’appel
+        word = (word_index >= 0 && word_index < currentenv->dictionary.count) ?
+               dictWord(&currentenv->dictionary, word_index) : frame->word;
+        ip = frame->ip;
+        unchecked = frame->unchecked;
+    }
+    if (ip > word->code_length) {
+        vm_throw(THROW_ABORT, "Invalid return address");
+    }
+    goto vm_resume;
+vm_enter:
+    ip = 0;
+    // Seul contrôle d’un mot vérifié : assez de cellules à lire, et la place de sa croissance
+    unchecked = word->unchecked && stack->top + 1 >= word->stack_in &&
+                (stack->top + word->stack_grow < stack->capacity ||
+                 stack_reserve(stack, stack->top + word->stack_grow + 1));
+vm_resume:
+    VM_SAFEPOINT();
+#ifdef FORTH_THREADED
+    if (!word->threaded && !threadWord(word)) {
+        vm_throw(THROW_ABORT, "Threaded code allocation failed");
+    }
+    threaded = unchecked && word->unchecked ? word->unchecked : word->threaded;
+#endif
+    code = word->code;
+    VM_DISPATCH();
+vm_abort:
+    currentenv->frame_top = frame_base;
+    currentenv->loop_stack_top = loop_base;
+    if (currentenv->return_stack.top > return_base) currentenv->return_stack.top = return_base;
+    if (currentenv->gmp->live_bytes > currentenv->gmp->quota) gmp_reclaim(currentenv);
+vm_leave:
+    currentenv->catch_top = currentenv->catch_base;
+    currentenv->catch_base = outer_catch_base;
+    currentenv->abort_point = outer_abort_point;
+}
+// Ajoute une instruction au mot en cours ; son code grandit par doublement, sans taille maximale
+static int emitInstruction(Env *env, Instruction instr) {
+    if (env->currentWord.code_length >= env->code_capacity) {
+        long int capacity = env->code_capacity ? env->code_capacity * 2 : 64;
+        Instruction *code = realloc(env->currentWord.code, capacity * sizeof(Instruction));
+        if (!code) {
+            set_error("Word code allocation failed");
+            env->compile_error = 1;
+            return 0;
+        }
+        env->currentWord.code = code;
+        env->code_capacity = capacity;
+    }
+    env->currentWord.code[env->currentWord.code_length++] = instr;
+    return 1;
+}
+
+// Ajoute au mot en cours une chaîne dont il prend la référence ; renvoie son index, -1 en cas d’échec
+static long int addWordString(Env *env, char *str) {
+    if (env->currentWord.string_count >= env->string_capacity_word) {
+        long int capacity = env->string_capacity_word ? env->string_capacity_word * 2 : 8;
+        char **strings = realloc(env->currentWord.strings, capacity * sizeof(char *));
+        if (!strings) {
+            fstr_release(&env->arena, str);
+            set_error("Word string allocation failed");
+            env->compile_error = 1;
+            return -1;
+        }
+        env->currentWord.strings = strings;
+        env->string_capacity_word = capacity;
+    }
+    env->currentWord.strings[env->currentWord.string_count] = str;
+    return env->currentWord.string_count++;
+}
+
+// ";" : recopie le mot en cours dans l’emplacement idx, code et chaînes à leur taille exacte
+// dans l’arène. Les tableaux de currentWord restent pour la définition suivante.
+static int storeCurrentWord(Env *env, long int idx) {
+    CompiledWord *cur = &env->currentWord;
+    Instruction *code = (Instruction *)arena_alloc(&env->arena, cur->code_length * sizeof(Instruction));
+    char **strings = NULL;
+    if (code && cur->string_count > 0) {
+        strings = (char **)arena_alloc(&env->arena, cur->string_count * sizeof(char *));
+        if (!strings) {
+            arena_free(&env->arena, code, cur->code_length * sizeof(Instruction));
+            code = NULL;
+        }
+    }
+    if (!code) return 0;
+    memcpy(code, cur->code, cur->code_length * sizeof(Instruction));
+    if (strings) memcpy(strings, cur->strings, cur->string_count * sizeof(char *));
+    CompiledWord *word = dictWord(&env->dictionary, idx);
+    int called = word->called; // Les appelants de l’ancienne définition restent
+    *word = *cur;
+    word->called = called;
+    word->code = code;
+    word->strings = strings;
+    return 1;
+}
+
+// LOOP / +LOOP vient d’être compilé : les LEAVE encore en attente depuis le DO sortent ici
+// (ceux des boucles internes ont déjà été résolus par leur propre LOOP)
+static void patchLeaves(CompiledWord *word, long int do_addr) {
+    for (long int i = do_addr + 1; i < word->code_length; i++) {
+        if (word->code[i].opcode == OP_LEAVE && word->code[i].operand < 0) {
+            word->code[i].operand = word->code_length;
+        }
     }
 }
 void interpret(char *input, Stack *stack) {
     if (!currentenv) return;
+    // Appelé par LOAD depuis la VM : la compilation ne déroute pas, et les CATCH de l’appelant
+    // ne voient pas les erreurs de la ligne (chaque mot exécuté a son propre point de reprise)
+    jmp_buf *outer_abort_point = currentenv->abort_point;
+    int outer_catch_base = currentenv->catch_base;
+    currentenv->abort_point = NULL;
+    currentenv->catch_base = currentenv->catch_top;
     currentenv->error_flag = 0;
     currentenv->compile_error = 0;
+    // Dépassement laissé par une ligne précédente (limbs de cellules dépilées depuis, erreur hors
+    // VM comme un littéral trop grand) : sinon le premier littéral de la ligne échoue encore
+    if (!outer_abort_point && currentenv->gmp->live_bytes > currentenv->gmp->quota) gmp_reclaim(currentenv);
     char *saveptr;
     char *token = strtok_r(input, " \t\n", &saveptr);
     while (token && !currentenv->error_flag && !currentenv->compile_error) {
@@ -2268,6 +4332,44 @@ void interpret(char *input, Stack *stack) {
         compileToken(token, &saveptr, currentenv);
         token = strtok_r(NULL, " \t\n", &saveptr);
     }
+    currentenv->abort_point = outer_abort_point;
+    currentenv->catch_base = outer_catch_base;
+}
+// Hors mots-clés : appel d’un mot du dictionnaire ou littéral numérique. 0 si le jeton est inconnu.
+static int compileReference(char *token, Env *env, Instruction *instr) {
+    int index = findCompiledWordIndex(token);
+    if (index >= 0) {
+        instr->opcode = OP_CALL;
+        instr->operand = index;
+    } else {
+        mpz_t test_num;
+        mpz_init(test_num);
+        if (mpz_set_str(test_num, token, 10) == 0) {
+            // Littéral parsé une seule fois : inline s’il tient dans un long, sinon dans le pool
+            if (mpz_fits_slong_p(test_num)) {
+                instr->opcode = OP_PUSH;
+                instr->operand = mpz_get_si(test_num);
+            } else {
+                instr->opcode = OP_PUSH_BIG;
+                instr->operand = addWordConstant(&env->currentWord, test_num);
+                if (instr->operand < 0) {
+                    set_error("Literal allocation failed");
+                    env->compile_error = 1;
+                    mpz_clear(test_num);
+                    return 0;
+                }
+            }
+        } else {
+            char msg[512];
+            snprintf(msg, sizeof(msg), "Unknown word in definition: %s", token);
+            send_to_channel(msg);
+            env->compile_error = 1;
+            mpz_clear(test_num);
+            return 0;
+        }
+        mpz_clear(test_num);
+    }
+    return 1;
 }
 void compileToken(char *token, char **input_rest, Env *env) {
     Instruction instr = {0};
@@ -2275,7 +4377,7 @@ void compileToken(char *token, char **input_rest, Env *env) {
 
     // Vérification des mots immédiats (exécutés dans tous les modes)
     int idx = findCompiledWordIndex(token);
-    if (idx >= 0 && env->dictionary.words[idx].immediate) {
+    if (idx >= 0 && dictWord(&env->dictionary, idx)->immediate) {
         if (strcmp(token, "STRING") == 0) {
             char *next_token = strtok_r(NULL, " \t\n", input_rest);
             if (!next_token) {
@@ -2302,18 +4404,16 @@ void compileToken(char *token, char **input_rest, Env *env) {
                 resizeDynamicDictionary(&env->dictionary);
             }
             int dict_idx = env->dictionary.count++;
-            env->dictionary.words[dict_idx].name = strdup(next_token);
-            env->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-            env->dictionary.words[dict_idx].code[0].operand = index;
-            env->dictionary.words[dict_idx].code_length = 1;
-            env->dictionary.words[dict_idx].string_count = 0;
-            env->dictionary.words[dict_idx].immediate = 0; // Pas immédiat après création
+            dictWord(&env->dictionary, dict_idx)->name = arena_strdup(&env->arena, next_token);
+            dictIndexAdd(&env->dictionary, dict_idx);
+            setWordInstruction(&env->dictionary, dictWord(&env->dictionary, dict_idx), OP_PUSH, index);
+            dictWord(&env->dictionary, dict_idx)->string_count = 0;
+            dictWord(&env->dictionary, dict_idx)->immediate = 0; // Pas immédiat après création
             // Si en mode compilation, ajoute l’instruction
             if (env->compiling) {
                 instr.opcode = OP_STRING;
-                instr.operand = env->currentWord.string_count;
-                env->currentWord.strings[env->currentWord.string_count++] = strdup(next_token);
-                env->currentWord.code[env->currentWord.code_length++] = instr;
+                instr.operand = addWordString(env, fstr_new(&env->arena, next_token, strlen(next_token)));
+                if (instr.operand >= 0) emitInstruction(env, instr);
             }
         } else if (strcmp(token, "FORGET") == 0) {
             char *next_token = strtok_r(NULL, " \t\n", input_rest);
@@ -2322,13 +4422,19 @@ void compileToken(char *token, char **input_rest, Env *env) {
                 env->compile_error = 1;
                 return;
             }
+            Instruction temp_code[1];
+            char *temp_strings[1];
             CompiledWord temp_word = {0};
-            temp_word.strings[0] = strdup(next_token);
+            temp_word.code = temp_code;
+            temp_word.strings = temp_strings;
+            temp_word.strings[0] = fstr_new(&env->arena, next_token, strlen(next_token));
             temp_word.string_count = 1;
-            instr.opcode = OP_FORGET;
-            instr.operand = 0; // Index 0 dans temp_word.strings
-            executeInstruction(instr, &env->main_stack, NULL, &temp_word, -1);
-            free(temp_word.strings[0]);
+            temp_word.code[0].opcode = OP_FORGET;
+            temp_word.code[0].operand = 0; // Index 0 dans temp_word.strings
+            temp_word.code_length = 1;
+            executeCompiledWord(&temp_word, &env->main_stack, -1);
+            fstr_release(&env->arena, temp_word.strings[0]);
+            freeWordCode(&temp_word);
             return;
         }
         return; // Sortir après exécution immédiate
@@ -2343,22 +4449,23 @@ if (strcmp(token, ":") == 0) {
         return;
     }
     env->compiling = 1;
-    int existing_idx = findCompiledWordIndex(next_token);
+    int existing_idx = dictLookupOwn(&env->dictionary, next_token);
     if (existing_idx >= 0) {
         // Réutiliser l’emplacement existant
         env->current_word_index = existing_idx;
         // Libérer les anciennes ressources si nécessaire
-        if (env->dictionary.words[existing_idx].name) {
-            free(env->dictionary.words[existing_idx].name);
+        if (dictWord(&env->dictionary, existing_idx)->name) {
+            arena_free_str(&env->arena, dictWord(&env->dictionary, existing_idx)->name);
         }
-        for (int j = 0; j < env->dictionary.words[existing_idx].string_count; j++) {
-            if (env->dictionary.words[existing_idx].strings[j]) {
-                free(env->dictionary.words[existing_idx].strings[j]);
+        for (int j = 0; j < dictWord(&env->dictionary, existing_idx)->string_count; j++) {
+            if (dictWord(&env->dictionary, existing_idx)->strings[j]) {
+                fstr_release(&env->arena, dictWord(&env->dictionary, existing_idx)->strings[j]);
             }
         }
-        env->dictionary.words[existing_idx].name = NULL; // Sécurité
-        env->dictionary.words[existing_idx].code_length = 0;
-        env->dictionary.words[existing_idx].string_count = 0;
+        freeWordCode(dictWord(&env->dictionary, existing_idx));
+        freeWordBody(dictWord(&env->dictionary, existing_idx), &env->arena);
+        dictWord(&env->dictionary, existing_idx)->name = NULL; // Sécurité
+        reverifyCallersOf(&env->dictionary, existing_idx); // Plus d’effet connu jusqu’à ";"
     } else {
         // Nouveau mot
         env->current_word_index = env->dictionary.count;
@@ -2367,9 +4474,10 @@ if (strcmp(token, ":") == 0) {
         }
         env->dictionary.count++; // Incrémenter uniquement si nouveau
     }
-    env->currentWord.name = strdup(next_token);
+    env->currentWord.name = arena_strdup(&env->arena, next_token);
     env->currentWord.code_length = 0;
     env->currentWord.string_count = 0;
+    freeWordCode(&env->currentWord); // Restes d’une définition avortée
     env->control_stack_top = 0;
     return;
 }
@@ -2389,12 +4497,25 @@ if (strcmp(token, ";") == 0) {
         return;
     }
     instr.opcode = OP_END;
-    env->currentWord.code[env->currentWord.code_length++] = instr;
+    if (!emitInstruction(env, instr)) {
+        env->compiling = 0;
+        env->control_stack_top = 0;
+        return;
+    }
     if (env->current_word_index >= 0 && env->current_word_index < env->dictionary.capacity) {
-        env->dictionary.words[env->current_word_index] = env->currentWord;
+        if (!storeCurrentWord(env, env->current_word_index)) {
+            set_error("Word code allocation failed");
+            env->compile_error = 1;
+            env->compiling = 0;
+            env->control_stack_top = 0;
+            return;
+        }
         if (env->current_word_index == env->dictionary.count) {
             env->dictionary.count++;
         }
+        dictIndexAdd(&env->dictionary, env->current_word_index);
+        finalizeWord(dictWord(&env->dictionary, env->current_word_index), env->current_word_index, &env->dictionary);
+        recompileDependents(&env->dictionary, env->current_word_index);
     } else {
         set_error("Dictionary index out of bounds");
         env->compile_error = 1;
@@ -2406,6 +4527,13 @@ if (strcmp(token, ";") == 0) {
     env->currentWord.name = NULL; // Juste réinitialiser pour éviter une double libération
     env->currentWord.code_length = 0;
     env->currentWord.string_count = 0;
+    env->currentWord.constants = NULL; // Le pool appartient désormais au dictionnaire
+    env->currentWord.constant_count = 0;
+    env->currentWord.threaded = NULL;
+    env->currentWord.source = NULL;
+    env->currentWord.source_length = 0;
+    env->currentWord.inlined = NULL;
+    env->currentWord.inlined_count = 0;
     return;
 }
     // Récursion dans une définition
@@ -2417,7 +4545,36 @@ if (strcmp(token, ";") == 0) {
         }
         instr.opcode = OP_CALL;
         instr.operand = env->current_word_index;
-        env->currentWord.code[env->currentWord.code_length++] = instr;
+        emitInstruction(env, instr);
+        return;
+    }
+    // Boucle hors définition : LOOP n’a pas de DO où revenir, l’entrée de DO resterait sur la pile de boucles
+    if (!env->compiling && (strcmp(token, "DO") == 0 || strcmp(token, "LOOP") == 0 || strcmp(token, "+LOOP") == 0)) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%s outside definition", token);
+        set_error(msg);
+        env->compile_error = 1;
+        return;
+    }
+
+    // ' nom : index du mot (le xt de CATCH, comme celui que SEE accepte sur la pile)
+    if (strcmp(token, "'") == 0) {
+        char *next_token = strtok_r(NULL, " \t\n", input_rest);
+        int index = next_token ? findCompiledWordIndex(next_token) : -1;
+        if (index < 0) {
+            char msg[512];
+            snprintf(msg, sizeof(msg), "': Unknown word: %s", next_token ? next_token : "");
+            set_error(msg);
+            env->compile_error = 1;
+            return;
+        }
+        if (env->compiling) {
+            instr.opcode = OP_PUSH;
+            instr.operand = index;
+            emitInstruction(env, instr);
+        } else {
+            push_si(&env->main_stack, index);
+        }
         return;
     }
 
@@ -2446,34 +4603,11 @@ if (strcmp(token, ";") == 0) {
     // Gestion de CASE
  
         // Instructions Forth de base
-        if (strcmp(token, "DUP") == 0) instr.opcode = OP_DUP;
-        else if (strcmp(token, "DROP") == 0) instr.opcode = OP_DROP;
-        else if (strcmp(token, "SWAP") == 0) instr.opcode = OP_SWAP;
-        else if (strcmp(token, "OVER") == 0) instr.opcode = OP_OVER;
-        else if (strcmp(token, "ROT") == 0) instr.opcode = OP_ROT;
-        else if (strcmp(token, "+") == 0) instr.opcode = OP_ADD;
-        else if (strcmp(token, "-") == 0) instr.opcode = OP_SUB;
-        else if (strcmp(token, "*") == 0) instr.opcode = OP_MUL;
-        else if (strcmp(token, "/") == 0) instr.opcode = OP_DIV;
-        else if (strcmp(token, "MOD") == 0) instr.opcode = OP_MOD;
-        else if (strcmp(token, "=") == 0) instr.opcode = OP_EQ;
-        else if (strcmp(token, "<") == 0) instr.opcode = OP_LT;
-        else if (strcmp(token, ">") == 0) instr.opcode = OP_GT;
-        else if (strcmp(token, "AND") == 0) instr.opcode = OP_AND;
-        else if (strcmp(token, "OR") == 0) instr.opcode = OP_OR;
-        else if (strcmp(token, "NOT") == 0) instr.opcode = OP_NOT;
-        else if (strcmp(token, "XOR") == 0) instr.opcode = OP_XOR;
-        else if (strcmp(token, ".") == 0) instr.opcode = OP_DOT;
-        else if (strcmp(token, ".S") == 0) instr.opcode = OP_DOT_S;
-        else if (strcmp(token, "CR") == 0) instr.opcode = OP_CR;
-        else if (strcmp(token, "EMIT") == 0) instr.opcode = OP_EMIT;
-        else if (strcmp(token, "@") == 0) instr.opcode = OP_FETCH;
-        else if (strcmp(token, "!") == 0) instr.opcode = OP_STORE;
-        else if (strcmp(token, ">R") == 0) instr.opcode = OP_TO_R;
-        else if (strcmp(token, "R>") == 0) instr.opcode = OP_FROM_R;
-        else if (strcmp(token, "R@") == 0) instr.opcode = OP_R_FETCH;
-        else if (strcmp(token, "I") == 0) instr.opcode = OP_I;
-        else if (strcmp(token, "J") == 0) instr.opcode = OP_J;
+        const Primitive *prim = findPrimitive(token);
+        if (prim && (prim->flags & PRIM_INLINE)) instr.opcode = prim->opcode;
+        else if (!prim || !(prim->flags & PRIM_SYNTAX)) {
+            if (!compileReference(token, env, &instr)) return;
+        }
 else if (strcmp(token, "DO") == 0) {
     if (env->control_stack_top >= CONTROL_STACK_SIZE) {
         set_error("Control stack overflow");
@@ -2483,7 +4617,7 @@ else if (strcmp(token, "DO") == 0) {
     instr.opcode = OP_DO;
     instr.operand = 0; // Pas utilisé directement ici
     env->control_stack[env->control_stack_top++] = (ControlEntry){CT_DO, env->currentWord.code_length};
-    env->currentWord.code[env->currentWord.code_length++] = instr;
+    emitInstruction(env, instr);
     return;
 }
 else if (strcmp(token, "LOOP") == 0) {
@@ -2495,7 +4629,8 @@ else if (strcmp(token, "LOOP") == 0) {
     ControlEntry do_entry = env->control_stack[--env->control_stack_top];
     instr.opcode = OP_LOOP;
     instr.operand = do_entry.addr + 1; // Pointe vers l'instruction APRÈS DO
-    env->currentWord.code[env->currentWord.code_length++] = instr;
+    emitInstruction(env, instr);
+    patchLeaves(&env->currentWord, do_entry.addr);
     return;
 }
 else if (strcmp(token, "+LOOP") == 0) {
@@ -2507,23 +4642,25 @@ else if (strcmp(token, "+LOOP") == 0) {
     ControlEntry do_entry = env->control_stack[--env->control_stack_top];
     instr.opcode = OP_PLUS_LOOP;
     instr.operand = do_entry.addr + 1; // Pointe vers l'instruction APRÈS DO
-    env->currentWord.code[env->currentWord.code_length++] = instr;
+    emitInstruction(env, instr);
+    patchLeaves(&env->currentWord, do_entry.addr);
+    return;
+}
+else if (strcmp(token, "LEAVE") == 0) {
+    int in_do = 0;
+    for (int i = env->control_stack_top - 1; i >= 0 && !in_do; i--) {
+        in_do = env->control_stack[i].type == CT_DO;
+    }
+    if (!in_do) {
+        set_error("LEAVE without DO");
+        env->compile_error = 1;
+        return;
+    }
+    instr.opcode = OP_LEAVE;
+    instr.operand = -1; // Fixé par patchLeaves au LOOP correspondant
+    emitInstruction(env, instr);
     return;
 }
-        else if (strcmp(token, "PICK") == 0) instr.opcode = OP_PICK;
-        else if (strcmp(token, "EXIT") == 0) instr.opcode = OP_EXIT;
-        else if (strcmp(token, "CLOCK") == 0) instr.opcode = OP_CLOCK;
-        else if (strcmp(token, "CLEAR-STACK") == 0) instr.opcode = OP_CLEAR_STACK;
-        else if (strcmp(token, "WORDS") == 0) instr.opcode = OP_WORDS;
-        else if (strcmp(token, "NUM-TO-BIN") == 0) instr.opcode = OP_NUM_TO_BIN;
-        else if (strcmp(token, "PRIME?") == 0) instr.opcode = OP_PRIME_TEST;
-        // Opérateurs bit à bit
-        else if (strcmp(token, "&") == 0) instr.opcode = OP_BIT_AND;
-        else if (strcmp(token, "|") == 0) instr.opcode = OP_BIT_OR;
-        else if (strcmp(token, "^") == 0) instr.opcode = OP_BIT_XOR;
-        else if (strcmp(token, "~") == 0) instr.opcode = OP_BIT_NOT;
-        else if (strcmp(token, "<<") == 0) instr.opcode = OP_LSHIFT;
-        else if (strcmp(token, ">>") == 0) instr.opcode = OP_RSHIFT;
         // Gestion de ."
         else if (strcmp(token, ".\"") == 0) {
             char *start = *input_rest;
@@ -2533,14 +4670,10 @@ else if (strcmp(token, "+LOOP") == 0) {
                 env->compile_error = 1;
                 return;
             }
-            long int len = end - start;
-            char *str = malloc(len + 1);
-            strncpy(str, start, len);
-            str[len] = '\0';
+            char *str = fstr_new(&env->arena, start, end - start);
             instr.opcode = OP_DOT_QUOTE;
-            instr.operand = env->currentWord.string_count;
-            env->currentWord.strings[env->currentWord.string_count++] = str;
-            env->currentWord.code[env->currentWord.code_length++] = instr;
+            instr.operand = addWordString(env, str);
+            if (instr.operand >= 0) emitInstruction(env, instr);
             *input_rest = end + 1;
             while (**input_rest == ' ' || **input_rest == '\t') (*input_rest)++;
             return;
@@ -2552,7 +4685,7 @@ else if (strcmp(token, "+LOOP") == 0) {
         set_error("VARIABLE requires a name");
         return;
     }
-    int existing_idx = findCompiledWordIndex(next_token);
+    int existing_idx = dictLookupOwn(&env->dictionary, next_token);
     unsigned long encoded_index = memory_create(&env->memory_list, next_token, TYPE_VAR);
     if (encoded_index == 0) {
         set_error("VARIABLE: Memory creation failed");
@@ -2560,32 +4693,31 @@ else if (strcmp(token, "+LOOP") == 0) {
     }
     if (existing_idx >= 0) {
         // Remplacer l’ancienne définition
-        if (env->dictionary.words[existing_idx].name) {
-            free(env->dictionary.words[existing_idx].name);
+        if (dictWord(&env->dictionary, existing_idx)->name) {
+            arena_free_str(&env->arena, dictWord(&env->dictionary, existing_idx)->name);
         }
-        for (int j = 0; j < env->dictionary.words[existing_idx].string_count; j++) {
-            if (env->dictionary.words[existing_idx].strings[j]) {
-                free(env->dictionary.words[existing_idx].strings[j]);
+        for (int j = 0; j < dictWord(&env->dictionary, existing_idx)->string_count; j++) {
+            if (dictWord(&env->dictionary, existing_idx)->strings[j]) {
+                fstr_release(&env->arena, dictWord(&env->dictionary, existing_idx)->strings[j]);
             }
         }
-        env->dictionary.words[existing_idx].name = strdup(next_token);
-        env->dictionary.words[existing_idx].code[0].opcode = OP_PUSH;
-        env->dictionary.words[existing_idx].code[0].operand = encoded_index;
-        env->dictionary.words[existing_idx].code_length = 1;
-        env->dictionary.words[existing_idx].string_count = 0;
-        env->dictionary.words[existing_idx].immediate = 0;
+        freeWordCode(dictWord(&env->dictionary, existing_idx));
+        freeWordBody(dictWord(&env->dictionary, existing_idx), &env->arena);
+        dictWord(&env->dictionary, existing_idx)->name = arena_strdup(&env->arena, next_token);
+        setWordInstruction(&env->dictionary, dictWord(&env->dictionary, existing_idx), OP_PUSH, encoded_index);
+        dictWord(&env->dictionary, existing_idx)->immediate = 0;
+        recompileDependents(&env->dictionary, existing_idx);
     } else {
         // Nouveau mot
         if (env->dictionary.count >= env->dictionary.capacity) {
             resizeDynamicDictionary(&env->dictionary);
         }
         int dict_idx = env->dictionary.count++;
-        env->dictionary.words[dict_idx].name = strdup(next_token);
-        env->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-        env->dictionary.words[dict_idx].code[0].operand = encoded_index;
-        env->dictionary.words[dict_idx].code_length = 1;
-        env->dictionary.words[dict_idx].string_count = 0;
-        env->dictionary.words[dict_idx].immediate = 0;
+        dictWord(&env->dictionary, dict_idx)->name = arena_strdup(&env->arena, next_token);
+        dictIndexAdd(&env->dictionary, dict_idx);
+        setWordInstruction(&env->dictionary, dictWord(&env->dictionary, dict_idx), OP_PUSH, encoded_index);
+        dictWord(&env->dictionary, dict_idx)->string_count = 0;
+        dictWord(&env->dictionary, dict_idx)->immediate = 0;
     }
 }
         // Gestion de "
@@ -2597,19 +4729,12 @@ else if (strcmp(token, "+LOOP") == 0) {
                 env->compile_error = 1;
                 return;
             }
-            long int len = end - start;
-            char *str = malloc(len + 1);
-            strncpy(str, start, len);
-            str[len] = '\0';
             if (env->compiling) {
                 instr.opcode = OP_QUOTE;
-                instr.operand = env->currentWord.string_count;
-                env->currentWord.strings[env->currentWord.string_count++] = str;
-                env->currentWord.code[env->currentWord.code_length++] = instr;
+                instr.operand = addWordString(env, fstr_new(&env->arena, start, end - start));
+                if (instr.operand >= 0) emitInstruction(env, instr);
             } else {
-                push_string(str);
-                mpz_set_si(mpz_pool[0], env->string_stack_top);
-                push(&env->main_stack, mpz_pool[0]);
+                push_string_handle(&env->main_stack, fstr_new(&env->arena, start, end - start));
             }
             *input_rest = end + 1;
             while (**input_rest == ' ' || **input_rest == '\t') (*input_rest)++;
@@ -2629,7 +4754,7 @@ else if (strcmp(token, "+LOOP") == 0) {
             instr.opcode = OP_BRANCH_FALSE;
             instr.operand = 0; // À remplir avec THEN ou ELSE
             env->control_stack[env->control_stack_top++] = (ControlEntry){CT_IF, env->currentWord.code_length};
-            env->currentWord.code[env->currentWord.code_length++] = instr;
+            emitInstruction(env, instr);
             return;
         }
         else if (strcmp(token, "ELSE") == 0) {
@@ -2644,7 +4769,7 @@ else if (strcmp(token, "+LOOP") == 0) {
             instr.operand = 0; // À remplir avec THEN
             env->control_stack[env->control_stack_top - 1].type = CT_ELSE;
             env->control_stack[env->control_stack_top - 1].addr = env->currentWord.code_length;
-            env->currentWord.code[env->currentWord.code_length++] = instr;
+            emitInstruction(env, instr);
             return;
         }
         else if (strcmp(token, "THEN") == 0) {
@@ -2669,9 +4794,10 @@ else if (strcmp(token, "+LOOP") == 0) {
                 env->compile_error = 1;
                 return;
             }
+            // Marqueur pour SEE seulement : optimizeCode le retire du code exécuté
             instr.opcode = OP_BEGIN;
             env->control_stack[env->control_stack_top++] = (ControlEntry){CT_BEGIN, env->currentWord.code_length};
-            env->currentWord.code[env->currentWord.code_length++] = instr;
+            emitInstruction(env, instr);
             return;
         }
         else if (strcmp(token, "WHILE") == 0) {
@@ -2680,11 +4806,16 @@ else if (strcmp(token, "+LOOP") == 0) {
                 env->compile_error = 1;
                 return;
             }
+            if (env->control_stack_top >= CONTROL_STACK_SIZE) {
+                set_error("Control stack overflow");
+                env->compile_error = 1;
+                return;
+            }
             instr.opcode = OP_WHILE;
             instr.operand = 0; // À remplir avec REPEAT
-            env->control_stack[env->control_stack_top - 1].type = CT_WHILE;
-            env->control_stack[env->control_stack_top - 1].addr = env->currentWord.code_length;
-            env->currentWord.code[env->currentWord.code_length++] = instr;
+            // Au-dessus du BEGIN, qui garde l’adresse de retour pour REPEAT
+            env->control_stack[env->control_stack_top++] = (ControlEntry){CT_WHILE, env->currentWord.code_length};
+            emitInstruction(env, instr);
             return;
         }
         else if (strcmp(token, "REPEAT") == 0) {
@@ -2693,12 +4824,24 @@ else if (strcmp(token, "+LOOP") == 0) {
                 env->compile_error = 1;
                 return;
             }
-            ControlEntry while_entry = env->control_stack[env->control_stack_top - 1];
+            ControlEntry while_entry = env->control_stack[--env->control_stack_top];
+            ControlEntry begin_entry = env->control_stack[--env->control_stack_top];
             env->currentWord.code[while_entry.addr].operand = env->currentWord.code_length + 1;
             instr.opcode = OP_REPEAT;
-            instr.operand = while_entry.addr - 8; // Retour à BEGIN
-            env->currentWord.code[env->currentWord.code_length++] = instr;
-            env->control_stack_top--;
+            instr.operand = begin_entry.addr; // Retour à BEGIN
+            emitInstruction(env, instr);
+            return;
+        }
+        else if (strcmp(token, "AGAIN") == 0) {
+            if (env->control_stack_top <= 0 || env->control_stack[env->control_stack_top - 1].type != CT_BEGIN) {
+                set_error("AGAIN without BEGIN");
+                env->compile_error = 1;
+                return;
+            }
+            ControlEntry begin_entry = env->control_stack[--env->control_stack_top];
+            instr.opcode = OP_AGAIN;
+            instr.operand = begin_entry.addr;
+            emitInstruction(env, instr);
             return;
         }
         else if (strcmp(token, "UNTIL") == 0) {
@@ -2710,7 +4853,7 @@ else if (strcmp(token, "+LOOP") == 0) {
             ControlEntry begin_entry = env->control_stack[--env->control_stack_top];
             instr.opcode = OP_UNTIL;
             instr.operand = begin_entry.addr;
-            env->currentWord.code[env->currentWord.code_length++] = instr;
+            emitInstruction(env, instr);
             return;
         }
         else if (strcmp(token, "CASE") == 0) {
@@ -2722,9 +4865,9 @@ else if (strcmp(token, "+LOOP") == 0) {
                 env->compile_error = 1;
                 return;
             }
-            instr.opcode = OP_CASE;
+            instr.opcode = OP_CASE; // Marqueur pour SEE, comme BEGIN
             env->control_stack[env->control_stack_top++] = (ControlEntry){CT_CASE, env->currentWord.code_length};
-            env->currentWord.code[env->currentWord.code_length++] = instr;
+            emitInstruction(env, instr);
             // snprintf(debug_msg, sizeof(debug_msg), "After CASE: control_stack_top=%d, type=%d", env->control_stack_top, env->control_stack[env->control_stack_top - 1].type);
             // send_to_channel(debug_msg);
             return;
@@ -2750,7 +4893,7 @@ else if (strcmp(token, "OF") == 0) {
     instr.opcode = OP_OF;
     instr.operand = 0; // À remplir avec ENDOF
     env->control_stack[env->control_stack_top++] = (ControlEntry){CT_OF, env->currentWord.code_length};
-    env->currentWord.code[env->currentWord.code_length++] = instr;
+    emitInstruction(env, instr);
     return;
 }
         // Gestion de ENDOF
@@ -2768,7 +4911,7 @@ else if (strcmp(token, "OF") == 0) {
             instr.opcode = OP_ENDOF;
             instr.operand = 0; // À remplir avec ENDCASE
             env->control_stack[env->control_stack_top++] = (ControlEntry){CT_ENDOF, env->currentWord.code_length};
-            env->currentWord.code[env->currentWord.code_length++] = instr;
+            emitInstruction(env, instr);
             return;
         }
         // Gestion de ENDCASE
@@ -2793,43 +4936,16 @@ else if (strcmp(token, "ENDCASE") == 0) {
         return;
     }
     instr.opcode = OP_ENDCASE;
-    env->currentWord.code[env->currentWord.code_length++] = instr;
+    emitInstruction(env, instr);
     // snprintf(debug_msg, sizeof(debug_msg), "After ENDCASE: control_stack_top=%d", env->control_stack_top);
     // send_to_channel(debug_msg);
     return;
 }
-        // Cas général : mot existant ou nombre
-        else {
-            int index = findCompiledWordIndex(token);
-            if (index >= 0) {
-                instr.opcode = OP_CALL;
-                instr.operand = index;
-            } else {
-                mpz_t test_num;
-                mpz_init(test_num);
-                if (mpz_set_str(test_num, token, 10) == 0) {
-                    instr.opcode = OP_PUSH;
-                    instr.operand = env->currentWord.string_count;
-                    env->currentWord.strings[env->currentWord.string_count++] = strdup(token);
-                } else {
-                    char msg[512];
-                    snprintf(msg, sizeof(msg), "Unknown word in definition: %s", token);
-                    send_to_channel(msg);
-                    env->compile_error = 1;
-                    mpz_clear(test_num);
-                    return;
-                }
-                mpz_clear(test_num);
-            }
-        }
+        // Structure syntaxique sans traitement ci-dessus : même chemin qu’un mot ordinaire
+        else if (!compileReference(token, env, &instr)) return;
 
         // Ajouter l’instruction au mot en cours
-        if (env->currentWord.code_length < WORD_CODE_SIZE) {
-            env->currentWord.code[env->currentWord.code_length++] = instr;
-        } else {
-            set_error("Word code size exceeded");
-            env->compile_error = 1;
-        }
+        emitInstruction(env, instr);
     }
 
     // Mode interprétation
@@ -2870,7 +4986,7 @@ else if (strcmp(token, "ENDCASE") == 0) {
         env->compile_error = 1;
         return;
     }
-    int existing_idx = findCompiledWordIndex(next_token);
+    int existing_idx = dictLookupOwn(&env->dictionary, next_token);
     unsigned long index = memory_create(&env->memory_list, next_token, TYPE_ARRAY);
     if (index == 0) {
         set_error("CREATE: Memory creation failed");
@@ -2879,26 +4995,23 @@ else if (strcmp(token, "ENDCASE") == 0) {
     }
     if (existing_idx >= 0) {
         // Remplacer l’ancienne définition
-        if (env->dictionary.words[existing_idx].name) {
-            free(env->dictionary.words[existing_idx].name);
+        if (dictWord(&env->dictionary, existing_idx)->name) {
+            arena_free_str(&env->arena, dictWord(&env->dictionary, existing_idx)->name);
         }
-        for (int j = 0; j < env->dictionary.words[existing_idx].string_count; j++) {
-            if (env->dictionary.words[existing_idx].strings[j]) {
-                free(env->dictionary.words[existing_idx].strings[j]);
+        for (int j = 0; j < dictWord(&env->dictionary, existing_idx)->string_count; j++) {
+            if (dictWord(&env->dictionary, existing_idx)->strings[j]) {
+                fstr_release(&env->arena, dictWord(&env->dictionary, existing_idx)->strings[j]);
             }
         }
-        env->dictionary.words[existing_idx].name = strdup(next_token);
-        env->dictionary.words[existing_idx].code[0].opcode = OP_PUSH;
-        env->dictionary.words[existing_idx].code[0].operand = index;
-        env->dictionary.words[existing_idx].code_length = 1;
-        env->dictionary.words[existing_idx].string_count = 0;
-        env->dictionary.words[existing_idx].immediate = 0;
+        freeWordCode(dictWord(&env->dictionary, existing_idx));
+        freeWordBody(dictWord(&env->dictionary, existing_idx), &env->arena);
+        dictWord(&env->dictionary, existing_idx)->name = arena_strdup(&env->arena, next_token);
+        setWordInstruction(&env->dictionary, dictWord(&env->dictionary, existing_idx), OP_PUSH, index);
+        dictWord(&env->dictionary, existing_idx)->immediate = 0;
+        recompileDependents(&env->dictionary, existing_idx);
         MemoryNode *node = memory_get(&env->memory_list, index);
         if (node && node->type == TYPE_ARRAY) {
-            node->value.array.data = (mpz_t *)malloc(sizeof(mpz_t));
-            mpz_init(node->value.array.data[0]);
-            mpz_set_ui(node->value.array.data[0], 0);
-            node->value.array.size = 1;
+            memory_array_resize(node, 1); // Tableau compact d’un élément
         }
     } else {
         // Nouveau mot
@@ -2906,25 +5019,20 @@ else if (strcmp(token, "ENDCASE") == 0) {
             resizeDynamicDictionary(&env->dictionary);
         }
         int dict_idx = env->dictionary.count++;
-        env->dictionary.words[dict_idx].name = strdup(next_token);
-        env->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-        env->dictionary.words[dict_idx].code[0].operand = index;
-        env->dictionary.words[dict_idx].code_length = 1;
-        env->dictionary.words[dict_idx].string_count = 0;
-        env->dictionary.words[dict_idx].immediate = 0;
+        dictWord(&env->dictionary, dict_idx)->name = arena_strdup(&env->arena, next_token);
+        dictIndexAdd(&env->dictionary, dict_idx);
+        setWordInstruction(&env->dictionary, dictWord(&env->dictionary, dict_idx), OP_PUSH, index);
+        dictWord(&env->dictionary, dict_idx)->string_count = 0;
+        dictWord(&env->dictionary, dict_idx)->immediate = 0;
         MemoryNode *node = memory_get(&env->memory_list, index);
         if (node && node->type == TYPE_ARRAY) {
-            node->value.array.data = (mpz_t *)malloc(sizeof(mpz_t));
-            mpz_init(node->value.array.data[0]);
-            mpz_set_ui(node->value.array.data[0], 0);
-            node->value.array.size = 1;
+            memory_array_resize(node, 1); // Tableau compact d’un élément
         }
     }
     if (env->compiling) {
         instr.opcode = OP_CREATE;
-        instr.operand = env->currentWord.string_count;
-        env->currentWord.strings[env->currentWord.string_count++] = strdup(next_token);
-        env->currentWord.code[env->currentWord.code_length++] = instr;
+        instr.operand = addWordString(env, fstr_new(&env->arena, next_token, strlen(next_token)));
+        if (instr.operand >= 0) emitInstruction(env, instr);
     }
 }
         else if (strcmp(token, "VARIABLE") == 0) {
@@ -2933,7 +5041,7 @@ else if (strcmp(token, "ENDCASE") == 0) {
         set_error("VARIABLE requires a name");
         return;
     }
-    int existing_idx = findCompiledWordIndex(next_token);
+    int existing_idx = dictLookupOwn(&env->dictionary, next_token);
     unsigned long encoded_index = memory_create(&env->memory_list, next_token, TYPE_VAR);
     if (encoded_index == 0) {
         set_error("VARIABLE: Memory creation failed");
@@ -2941,32 +5049,31 @@ else if (strcmp(token, "ENDCASE") == 0) {
     }
     if (existing_idx >= 0) {
         // Remplacer l’ancienne définition
-        if (env->dictionary.words[existing_idx].name) {
-            free(env->dictionary.words[existing_idx].name);
+        if (dictWord(&env->dictionary, existing_idx)->name) {
+            arena_free_str(&env->arena, dictWord(&env->dictionary, existing_idx)->name);
         }
-        for (int j = 0; j < env->dictionary.words[existing_idx].string_count; j++) {
-            if (env->dictionary.words[existing_idx].strings[j]) {
-                free(env->dictionary.words[existing_idx].strings[j]);
+        for (int j = 0; j < dictWord(&env->dictionary, existing_idx)->string_count; j++) {
+            if (dictWord(&env->dictionary, existing_idx)->strings[j]) {
+                fstr_release(&env->arena, dictWord(&env->dictionary, existing_idx)->strings[j]);
             }
         }
-        env->dictionary.words[existing_idx].name = strdup(next_token);
-        env->dictionary.words[existing_idx].code[0].opcode = OP_PUSH;
-        env->dictionary.words[existing_idx].code[0].operand = encoded_index;
-        env->dictionary.words[existing_idx].code_length = 1;
-        env->dictionary.words[existing_idx].string_count = 0;
-        env->dictionary.words[existing_idx].immediate = 0;
+        freeWordCode(dictWord(&env->dictionary, existing_idx));
+        freeWordBody(dictWord(&env->dictionary, existing_idx), &env->arena);
+        dictWord(&env->dictionary, existing_idx)->name = arena_strdup(&env->arena, next_token);
+        setWordInstruction(&env->dictionary, dictWord(&env->dictionary, existing_idx), OP_PUSH, encoded_index);
+        dictWord(&env->dictionary, existing_idx)->immediate = 0;
+        recompileDependents(&env->dictionary, existing_idx);
     } else {
         // Nouveau mot
         if (env->dictionary.count >= env->dictionary.capacity) {
             resizeDynamicDictionary(&env->dictionary);
         }
         int dict_idx = env->dictionary.count++;
-        env->dictionary.words[dict_idx].name = strdup(next_token);
-        env->dictionary.words[dict_idx].code[0].opcode = OP_PUSH;
-        env->dictionary.words[dict_idx].code[0].operand = encoded_index;
-        env->dictionary.words[dict_idx].code_length = 1;
-        env->dictionary.words[dict_idx].string_count = 0;
-        env->dictionary.words[dict_idx].immediate = 0;
+        dictWord(&env->dictionary, dict_idx)->name = arena_strdup(&env->arena, next_token);
+        dictIndexAdd(&env->dictionary, dict_idx);
+        setWordInstruction(&env->dictionary, dictWord(&env->dictionary, dict_idx), OP_PUSH, encoded_index);
+        dictWord(&env->dictionary, dict_idx)->string_count = 0;
+        dictWord(&env->dictionary, dict_idx)->immediate = 0;
     }
 }
         else if (strcmp(token, ".\"") == 0) {
@@ -2985,13 +5092,7 @@ else if (strcmp(token, "ENDCASE") == 0) {
                 set_error("Missing closing quote for \"");
                 return;
             }
-            long int len = end - start;
-            char *str = malloc(len + 1);
-            strncpy(str, start, len);
-            str[len] = '\0';
-            push_string(str);
-            mpz_set_si(mpz_pool[0], env->string_stack_top);
-            push(&env->main_stack, mpz_pool[0]);
+            push_string_handle(&env->main_stack, fstr_new(&env->arena, start, end - start));
             *input_rest = end + 1;
             while (**input_rest == ' ' || **input_rest == '\t') (*input_rest)++;
             char *next_token = strtok_r(NULL, " \t\n", input_rest);
@@ -3002,12 +5103,12 @@ else if (strcmp(token, "ENDCASE") == 0) {
         else {
             int idx = findCompiledWordIndex(token);
             if (idx >= 0) {
-                executeCompiledWord(&env->dictionary.words[idx], &env->main_stack, idx);
+                executeCompiledWord(dictWord(&env->dictionary, idx), &env->main_stack, idx);
             } else {
                 mpz_t test_num;
                 mpz_init(test_num);
                 if (mpz_set_str(test_num, token, 10) == 0) {
-                    push(&env->main_stack, test_num);
+                    push_mpz(&env->main_stack, test_num);
                 } else {
                     char msg[512];
                     snprintf(msg, sizeof(msg), "Unknown word: %s", token);
@@ -3143,9 +5244,10 @@ int main(int argc, char *argv[]) {
                     printf("DEBUG: QUIT detected for %s\n", nick);
                     Env *env = findEnv(nick);
                     if (env) {
+                        size_t arena_bytes = env->arena.bytes_used;
                         freeEnv(nick);
                         char quit_msg[512];
-                        snprintf(quit_msg, sizeof(quit_msg), "Environment for %s has been freed.", nick);
+                        snprintf(quit_msg, sizeof(quit_msg), "Environment for %s has been freed (%zu bytes).", nick, arena_bytes);
                         send_to_channel(quit_msg);
                     } else {
                         send_to_channel("No environment found for you to quit.");
@@ -3163,7 +5265,6 @@ int main(int argc, char *argv[]) {
                     }
                     currentenv = env;
                     printf("Created env for %s\n", nick);
-                    initDictionary(env);
                 } else {
                     currentenv = env;
                 }
@@ -1,73 +1,272 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
 #include "memory_forth.h"
 
+// Les fonctions mémoire de GMP peuvent être remplacées : le tampon est pris avec malloc
+// pour que l'appelant puisse toujours le rendre avec free.
+char *mpz_get_str_alloc(int base, mpz_srcptr z) {
+    char *str = (char *)malloc(mpz_sizeinbase(z, base) + 2);
+    if (str) mpz_get_str(str, base, z);
+    return str;
+}
+
+char *cell_get_str(const Cell *c) {
+    if (c->tag == CELL_BIG) return mpz_get_str_alloc(10, c->z);
+    char *str = (char *)malloc(24);
+    if (str) snprintf(str, 24, "%ld", c->small);
+    return str;
+}
+
+void arena_init(Arena *arena) {
+    memset(arena, 0, sizeof(Arena));
+}
+
+void arena_destroy(Arena *arena) {
+    while (arena->pages) {
+        ArenaPage *next = arena->pages->next;
+        free(arena->pages);
+        arena->pages = next;
+    }
+    while (arena->large) {
+        ArenaBlock *next = arena->large->next;
+        free(arena->large);
+        arena->large = next;
+    }
+    arena_init(arena);
+}
+
+// Classe du bloc : plus petite puissance de 2 (au moins 16) qui contient size
+static int arena_class(size_t size) {
+    int c = 0;
+    while (((size_t)1 << (ARENA_MIN_SHIFT + c)) < size) c++;
+    return c;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    if (!arena) return malloc(size);
+    if (size == 0) size = 1;
+    if (size > ARENA_MAX_SMALL) {
+        ArenaBlock *block = (ArenaBlock *)malloc(sizeof(ArenaBlock) + size);
+        if (!block) return NULL;
+        block->size = size;
+        block->prev = NULL;
+        block->next = arena->large;
+        if (arena->large) arena->large->prev = block;
+        arena->large = block;
+        arena->bytes_used += size;
+        arena->bytes_reserved += sizeof(ArenaBlock) + size;
+        return block + 1;
+    }
+    int c = arena_class(size);
+    size_t class_size = (size_t)1 << (ARENA_MIN_SHIFT + c);
+    void *ptr = arena->free_list[c];
+    if (ptr) {
+        arena->free_list[c] = *(void **)ptr;
+    } else {
+        ArenaPage *page = arena->pages;
+        if (!page || page->used + class_size > ARENA_PAGE_SIZE) {
+            page = (ArenaPage *)malloc(sizeof(ArenaPage) + ARENA_PAGE_SIZE);
+            if (!page) return NULL;
+            page->used = 0;
+            page->next = arena->pages;
+            arena->pages = page;
+            arena->bytes_reserved += sizeof(ArenaPage) + ARENA_PAGE_SIZE;
+        }
+        ptr = (char *)(page + 1) + page->used;
+        page->used += class_size;
+    }
+    arena->bytes_used += class_size;
+    return ptr;
+}
+
+void arena_free(Arena *arena, void *ptr, size_t size) {
+    if (!arena) {
+        free(ptr);
+        return;
+    }
+    if (!ptr) return;
+    if (size == 0) size = 1;
+    if (size > ARENA_MAX_SMALL) {
+        ArenaBlock *block = (ArenaBlock *)ptr - 1;
+        if (block->prev) block->prev->next = block->next;
+        else arena->large = block->next;
+        if (block->next) block->next->prev = block->prev;
+        arena->bytes_used -= block->size;
+        arena->bytes_reserved -= sizeof(ArenaBlock) + block->size;
+        free(block);
+        return;
+    }
+    int c = arena_class(size);
+    *(void **)ptr = arena->free_list[c];
+    arena->free_list[c] = ptr;
+    arena->bytes_used -= (size_t)1 << (ARENA_MIN_SHIFT + c);
+}
+
+char *arena_strndup(Arena *arena, const char *str, size_t len) {
+    char *copy = (char *)arena_alloc(arena, len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+char *arena_strdup(Arena *arena, const char *str) {
+    return arena_strndup(arena, str, strlen(str));
+}
+
+void arena_free_str(Arena *arena, char *str) {
+    if (str) arena_free(arena, str, strlen(str) + 1);
+}
+
+char *fstr_new(Arena *arena, const char *str, size_t len) {
+    if (len > UINT_MAX) return NULL;
+    FStrHeader *h = arena_alloc(arena, sizeof(FStrHeader) + len + 1);
+    if (!h) return NULL;
+    h->refs = 1;
+    h->len = (unsigned int)len;
+    char *s = (char *)(h + 1);
+    memcpy(s, str, len);
+    s[len] = '\0';
+    return s;
+}
+
+void fstr_release(Arena *arena, char *s) {
+    if (!s) return;
+    FStrHeader *h = FSTR_HDR(s);
+    if (--h->refs == 0) arena_free(arena, h, sizeof(FStrHeader) + h->len + 1);
+}
+
 void memory_init(MemoryList *list) {
     list->head = NULL;
     list->count = 0;
+    list->slots = NULL;
+    list->capacity = 0;
+    list->used = 0;
+    list->free_head = SLOT_NONE;
+    list->buckets = NULL;
+    list->bucket_count = 0;
+    list->arena = NULL;
 }
 
-MemoryNode *memory_get_by_name(MemoryList *list, const char *name) {
-    MemoryNode *current = list->head;
-    while (current) {
-        if (current->name && strcmp(current->name, name) == 0) {
-            return current;
+// FNV-1a, comme l'index du dictionnaire
+static unsigned long memory_hash(const char *name) {
+    unsigned long h = 2166136261UL;
+    while (*name) {
+        h ^= (unsigned char)*name++;
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+// Redimensionne l'index par nom ; la liste est parcourue de la queue vers la tête
+// pour que les homonymes les plus récents restent en tête de leur seau.
+static int memory_rehash(MemoryList *list, unsigned long bucket_count) {
+    MemoryNode **buckets = (MemoryNode **)calloc(bucket_count, sizeof(MemoryNode *));
+    if (!buckets) return 0;
+    MemoryNode *tail = list->head;
+    while (tail && tail->next) tail = tail->next;
+    for (MemoryNode *node = tail; node; node = node->prev) {
+        unsigned long b = node->hash & (bucket_count - 1);
+        node->name_next = buckets[b];
+        buckets[b] = node;
+    }
+    free(list->buckets);
+    list->buckets = buckets;
+    list->bucket_count = bucket_count;
+    return 1;
+}
+
+static MemoryNode *memory_find(MemoryList *list, const char *name) {
+    if (!list->bucket_count) return NULL;
+    unsigned long h = memory_hash(name);
+    for (MemoryNode *node = list->buckets[h & (list->bucket_count - 1)]; node; node = node->name_next) {
+        if (node->hash == h && strcmp(node->name, name) == 0) return node;
+    }
+    return NULL;
+}
+
+// Attribue un slot à node (réutilise un slot libéré si possible), SLOT_NONE si la table est pleine
+static unsigned long memory_slot_alloc(MemoryList *list, MemoryNode *node) {
+    unsigned long slot = list->free_head;
+    if (slot != SLOT_NONE) {
+        list->free_head = list->slots[slot].next_free;
+    } else {
+        if (list->used > SLOT_MASK) return SLOT_NONE;
+        if (list->used == list->capacity) {
+            unsigned long new_capacity = list->capacity ? list->capacity * 2 : 16;
+            MemorySlot *slots = (MemorySlot *)realloc(list->slots, new_capacity * sizeof(MemorySlot));
+            if (!slots) return SLOT_NONE;
+            list->slots = slots;
+            list->capacity = new_capacity;
         }
-        current = current->next;
+        slot = list->used++;
+        list->slots[slot].gen = 0;
     }
-    return NULL; // Retourne NULL si le nom n’est pas trouvé
+    list->slots[slot].node = node;
+    node->slot = slot;
+    return slot;
 }
+
+MemoryNode *memory_get_by_name(MemoryList *list, const char *name) {
+    return memory_find(list, name); // NULL si le nom n’est pas trouvé
+}
+
 unsigned long memory_create(MemoryList *list, const char *name, unsigned long type) {
-    MemoryNode *node = (MemoryNode *)malloc(sizeof(MemoryNode));
+    if (list->count >= list->bucket_count && !memory_rehash(list, list->bucket_count ? list->bucket_count * 2 : 64)) {
+        return 0;
+    }
+    MemoryNode *node = (MemoryNode *)arena_alloc(list->arena, sizeof(MemoryNode));
     if (!node) return 0;
+    node->name = arena_strdup(list->arena, name);
+    if (!node->name) {
+        arena_free(list->arena, node, sizeof(MemoryNode));
+        return 0;
+    }
+    unsigned long slot = memory_slot_alloc(list, node);
+    if (slot == SLOT_NONE) {
+        arena_free_str(list->arena, node->name);
+        arena_free(list->arena, node, sizeof(MemoryNode));
+        return 0;
+    }
 
-    node->name = strdup(name);
     node->type = type; // Le type est directement assigné (TYPE_VAR, TYPE_STRING, TYPE_ARRAY)
     node->next = list->head;
+    node->prev = NULL;
+    if (list->head) list->head->prev = node;
+    node->hash = memory_hash(node->name);
+    unsigned long b = node->hash & (list->bucket_count - 1);
+    node->name_next = list->buckets[b];
+    list->buckets[b] = node;
 
     // Initialisation selon le type
     if (type == TYPE_VAR) {
-        mpz_init(node->value.number);
-        mpz_set_ui(node->value.number, 0);
+        cell_init(&node->value.number);
     } else if (type == TYPE_STRING) {
         node->value.string = NULL;
     } else if (type == TYPE_ARRAY) {
         node->value.array.data = NULL;
+        node->value.array.packed = NULL;
         node->value.array.size = 0;
+        node->value.array.capacity = 0;
     }
 
     list->head = node;
-    unsigned long index = list->count++ & INDEX_MASK; // Index brut masqué
+    list->count++;
+    unsigned long index = (list->slots[slot].gen << GEN_SHIFT) | slot; // Handle : génération + slot
     unsigned long encoded_index = (type << 28) | index; // Encodage avec type dans les 4 bits supérieurs
 
     return encoded_index;
 }
 
+// Accès direct par le slot ; NULL si le slot est libre ou réattribué depuis (handle périmé)
 MemoryNode *memory_get(MemoryList *list, unsigned long encoded_index) {
-    MemoryNode *current = list->head;
-    unsigned long target_index = encoded_index & INDEX_MASK;
-    unsigned long pos = 0;
-
-    char debug_msg[512];
-    /* snprintf(debug_msg, sizeof(debug_msg), "memory_get: Looking for index=%lu", target_index);
-    send_to_channel(debug_msg);
-*/
-    while (current != NULL) {
-        unsigned long current_index = (list->count - 1 - pos) & INDEX_MASK;
-        /* snprintf(debug_msg, sizeof(debug_msg), "memory_get: Checking pos=%lu, current_index=%lu, type=%lu", pos, current_index, current->type);
-        send_to_channel(debug_msg);
-        */ 
-        if (current_index == target_index) {
-            return current;
-        }
-        current = current->next;
-        pos++;
-    }
-    /* snprintf(debug_msg, sizeof(debug_msg), "memory_get: Not found for index=%lu", target_index);
-    send_to_channel(debug_msg);
-    */ 
-    return NULL;
+    unsigned long slot = encoded_index & SLOT_MASK;
+    if (slot >= list->used) return NULL;
+    MemorySlot *entry = &list->slots[slot];
+    if (!entry->node || entry->gen != ((encoded_index & INDEX_MASK) >> GEN_SHIFT)) return NULL;
+    return entry->node;
 }
 unsigned long memory_get_type(unsigned long encoded_index) {
     return (encoded_index & TYPE_MASK) >> 28;
@@ -80,10 +279,10 @@ void memory_store(MemoryList *list, unsigned long encoded_index, void *data) {
     }
 
     if (node->type == TYPE_VAR) {
-        mpz_set(node->value.number, *(mpz_t *)data);
+        cell_set(&node->value.number, (Cell *)data);
     } else if (node->type == TYPE_STRING) {
-        if (node->value.string) free(node->value.string);
-        node->value.string = strdup((char *)data);
+        fstr_release(list->arena, node->value.string);
+        node->value.string = fstr_new(list->arena, (char *)data, strlen((char *)data));
     } else if (node->type == TYPE_ARRAY) {
         // Pour l'instant, non implémenté pour les tableaux
         // À ajouter si nécessaire (par exemple, stockage à un offset)
@@ -97,7 +296,7 @@ void memory_fetch(MemoryList *list, unsigned long encoded_index, void *result) {
     }
 
     if (node->type == TYPE_VAR) {
-        mpz_set(*(mpz_t *)result, node->value.number);
+        cell_set((Cell *)result, &node->value.number);
     } else if (node->type == TYPE_STRING) {
         char **str_result = (char **)result;
         *str_result = node->value.string ? strdup(node->value.string) : NULL;
@@ -107,43 +306,385 @@ void memory_fetch(MemoryList *list, unsigned long encoded_index, void *result) {
     }
 }
 
-void memory_free(MemoryList *list, const char *name) {
-    MemoryNode *prev = NULL, *node = list->head;
+// Le nœud prend la référence de str (aucune copie), l'ancienne valeur est relâchée
+void memory_store_string(MemoryList *list, unsigned long encoded_index, char *str) {
+    MemoryNode *node = memory_get(list, encoded_index);
+    if (!node || node->type != TYPE_STRING || memory_get_type(encoded_index) != TYPE_STRING) {
+        fstr_release(list->arena, str);
+        return;
+    }
+    fstr_release(list->arena, node->value.string);
+    node->value.string = str;
+}
 
-    while (node && strcmp(node->name, name) != 0) {
-        prev = node;
-        node = node->next;
+char *memory_fetch_string(MemoryList *list, unsigned long encoded_index) {
+    MemoryNode *node = memory_get(list, encoded_index);
+    if (!node || node->type != TYPE_STRING || memory_get_type(encoded_index) != TYPE_STRING) return NULL;
+    return node->value.string;
+}
+
+// Valeurs GMP et tableau du nœud (hors arène)
+static void memory_node_clear_values(MemoryNode *node) {
+    if (node->type == TYPE_VAR) {
+        cell_clear(&node->value.number);
+    } else if (node->type == TYPE_ARRAY) {
+        if (node->value.array.data) {
+            for (unsigned long i = 0; i < node->value.array.size; i++) {
+                cell_clear(&node->value.array.data[i]);
+            }
+            free(node->value.array.data);
+        }
+        free(node->value.array.packed);
     }
-    if (!node) return;
+}
 
-    if (prev) prev->next = node->next;
+// Contenu et nœud lui-même, sans toucher aux chaînages
+static void memory_node_clear(MemoryList *list, MemoryNode *node) {
+    memory_node_clear_values(node);
+    if (node->type == TYPE_STRING) fstr_release(list->arena, node->value.string);
+    arena_free_str(list->arena, node->name);
+    arena_free(list->arena, node, sizeof(MemoryNode));
+}
+
+// Retire node de la liste, de son seau et de la table de handles, puis le libère
+static void memory_release(MemoryList *list, MemoryNode *node) {
+    if (node->prev) node->prev->next = node->next;
     else list->head = node->next;
+    if (node->next) node->next->prev = node->prev;
 
-    if (node->type == TYPE_VAR) {
-        mpz_clear(node->value.number);
-    } else if (node->type == TYPE_STRING && node->value.string) {
-        free(node->value.string);
-    } else if (node->type == TYPE_ARRAY && node->value.array.data) {
-        for (unsigned long i = 0; i < node->value.array.size; i++) {
-            mpz_clear(node->value.array.data[i]);
+    MemoryNode **link = &list->buckets[node->hash & (list->bucket_count - 1)];
+    while (*link != node) link = &(*link)->name_next;
+    *link = node->name_next;
+
+    // Le slot repart dans la liste libre avec une nouvelle génération
+    MemorySlot *entry = &list->slots[node->slot];
+    entry->node = NULL;
+    entry->gen = (entry->gen + 1) & GEN_MASK;
+    entry->next_free = list->free_head;
+    list->free_head = node->slot;
+
+    memory_node_clear(list, node);
+    list->count--;
+}
+
+void memory_free(MemoryList *list, const char *name) {
+    MemoryNode *node = memory_find(list, name);
+    if (node) memory_release(list, node);
+}
+
+void memory_free_handle(MemoryList *list, unsigned long encoded_index) {
+    MemoryNode *node = memory_get(list, encoded_index);
+    if (node) memory_release(list, node);
+}
+
+// Agrandit le tableau à new_size éléments (nouveaux éléments à 0). La capacité double,
+// si bien qu'une suite d'ALLOT ne réalloue qu'un nombre logarithmique de fois.
+// Un tableau encore vide démarre compact.
+int memory_array_resize(MemoryNode *node, unsigned long new_size) {
+    unsigned long size = node->value.array.size;
+    if (new_size > node->value.array.capacity) {
+        unsigned long capacity = node->value.array.capacity * 2;
+        if (capacity < 8) capacity = 8;
+        if (capacity < new_size) capacity = new_size;
+        if (node->value.array.data) {
+            Cell *data = (Cell *)realloc(node->value.array.data, capacity * sizeof(Cell));
+            if (!data) return 0;
+            for (unsigned long i = node->value.array.capacity; i < capacity; i++) cell_init(&data[i]);
+            node->value.array.data = data;
+        } else {
+            long int *packed = (long int *)realloc(node->value.array.packed, capacity * sizeof(long int));
+            if (!packed) return 0;
+            node->value.array.packed = packed;
         }
+        node->value.array.capacity = capacity;
+    }
+    if (node->value.array.packed && new_size > size) {
+        memset(node->value.array.packed + size, 0, (new_size - size) * sizeof(long int));
+    }
+    node->value.array.size = new_size;
+    return 1;
+}
+
+int memory_array_promote(MemoryNode *node) {
+    if (!node->value.array.packed) return 1;
+    unsigned long capacity = node->value.array.capacity;
+    Cell *data = (Cell *)malloc((capacity ? capacity : 1) * sizeof(Cell));
+    if (!data) return 0;
+    for (unsigned long i = 0; i < capacity; i++) {
+        cell_init(&data[i]);
+        if (i < node->value.array.size) data[i].small = node->value.array.packed[i];
+    }
+    free(node->value.array.packed);
+    node->value.array.packed = NULL;
+    node->value.array.data = data;
+    return 1;
+}
+
+// Opérations en bloc sur les tableaux. Les tableaux compacts passent par des noyaux
+// vectoriels (extensions vectorielles de GCC, clonés pour AVX2 avec repli générique) ;
+// les tableaux de cellules par des boucles GMP.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define ARRAY_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define ARRAY_KERNEL
+#endif
+
+#define SIGN_BIT (1UL << 63)
+#define SUM_BLOCK (1UL << 30) // Éléments sommés sans risque de débordement des accumulateurs 64 bits
+
+#ifdef __GNUC__
+typedef long int v4si64 __attribute__((vector_size(32)));
+typedef unsigned long v4su64 __attribute__((vector_size(32)));
+#endif
+
+ARRAY_KERNEL static void packed_fill(long int *p, unsigned long n, long int v) {
+    unsigned long i = 0;
+#ifdef __GNUC__
+    v4si64 vv = {v, v, v, v};
+    for (; i + 4 <= n; i += 4) memcpy(p + i, &vv, sizeof(vv));
+#endif
+    for (; i < n; i++) p[i] = v;
+}
+
+// Somme exacte de n <= SUM_BLOCK éléments : u = x + 2^63 (non signé) est coupé en
+// moitiés de 32 bits sommées séparément, puis sum = hi * 2^32 + lo - n * 2^63.
+ARRAY_KERNEL static void packed_sum_parts(const long int *p, unsigned long n, unsigned long *hi, unsigned long *lo) {
+    unsigned long h = 0, l = 0, i = 0;
+#ifdef __GNUC__
+    v4su64 vh = {0, 0, 0, 0}, vl = {0, 0, 0, 0};
+    const v4su64 sign = {SIGN_BIT, SIGN_BIT, SIGN_BIT, SIGN_BIT};
+    for (; i + 4 <= n; i += 4) {
+        v4su64 u;
+        memcpy(&u, p + i, sizeof(u));
+        u ^= sign;
+        vh += u >> 32;
+        vl += u & 0xFFFFFFFFUL;
+    }
+    h = vh[0] + vh[1] + vh[2] + vh[3];
+    l = vl[0] + vl[1] + vl[2] + vl[3];
+#endif
+    for (; i < n; i++) {
+        unsigned long u = (unsigned long)p[i] ^ SIGN_BIT;
+        h += u >> 32;
+        l += u & 0xFFFFFFFFUL;
+    }
+    *hi = h;
+    *lo = l;
+}
+
+ARRAY_KERNEL static long int packed_max(const long int *p, unsigned long n) {
+    long int m = p[0];
+    unsigned long i = 0;
+#ifdef __GNUC__
+    if (n >= 4) {
+        v4si64 vm;
+        memcpy(&vm, p, sizeof(vm));
+        for (i = 4; i + 4 <= n; i += 4) {
+            v4si64 u;
+            memcpy(&u, p + i, sizeof(u));
+            v4si64 gt = u > vm;
+            vm = (u & gt) | (vm & ~gt);
+        }
+        for (int k = 0; k < 4; k++) if (vm[k] > m) m = vm[k];
+    }
+#endif
+    for (; i < n; i++) if (p[i] > m) m = p[i];
+    return m;
+}
+
+ARRAY_KERNEL static unsigned long packed_count(const long int *p, unsigned long n, long int v) {
+    unsigned long count = 0, i = 0;
+#ifdef __GNUC__
+    v4si64 vv = {v, v, v, v}, vc = {0, 0, 0, 0};
+    for (; i + 4 <= n; i += 4) {
+        v4si64 u;
+        memcpy(&u, p + i, sizeof(u));
+        vc -= u == vv; // -1 par égalité
+    }
+    count = vc[0] + vc[1] + vc[2] + vc[3];
+#endif
+    for (; i < n; i++) count += p[i] == v;
+    return count;
+}
+
+// Cellule depuis un entier 128 bits
+static void cell_set_i128(Cell *c, __int128 v) {
+    if (v >= LONG_MIN && v <= LONG_MAX) {
+        cell_set_si(c, (long int)v);
+        return;
+    }
+    cell_ensure_z(c);
+    mpz_set_si(c->z, (long int)(v >> 64));
+    mpz_mul_2exp(c->z, c->z, 64);
+    mpz_add_ui(c->z, c->z, (unsigned long)v);
+    c->tag = CELL_BIG;
+}
+
+static void mpz_add_long(mpz_ptr r, long int v) {
+    if (v >= 0) mpz_add_ui(r, r, (unsigned long)v);
+    else mpz_sub_ui(r, r, -(unsigned long)v);
+}
+
+int memory_array_fill(MemoryNode *node, const Cell *v) {
+    unsigned long n = node->value.array.size;
+    if (v->tag == CELL_SMALL && node->value.array.data) {
+        // Toutes les valeurs redeviennent natives : retour au tableau compact
+        long int *packed = (long int *)malloc((node->value.array.capacity ? node->value.array.capacity : 1) * sizeof(long int));
+        if (!packed) return 0;
+        for (unsigned long i = 0; i < node->value.array.capacity; i++) cell_clear(&node->value.array.data[i]);
         free(node->value.array.data);
+        node->value.array.data = NULL;
+        node->value.array.packed = packed;
     }
-    free(node->name);
-    free(node);
-    list->count--;
+    if (node->value.array.packed) {
+        if (v->tag == CELL_SMALL) {
+            packed_fill(node->value.array.packed, n, v->small);
+            return 1;
+        }
+        if (!memory_array_promote(node)) return 0;
+    }
+    for (unsigned long i = 0; i < n; i++) cell_set(&node->value.array.data[i], v);
+    return 1;
 }
 
-void print_variable(MemoryList *list, const char *name) {
+void memory_array_sum(const MemoryNode *node, Cell *out) {
+    unsigned long n = node->value.array.size;
+    if (node->value.array.packed) {
+        __int128 total = 0;
+        for (unsigned long start = 0; start < n; start += SUM_BLOCK) {
+            unsigned long len = n - start < SUM_BLOCK ? n - start : SUM_BLOCK, hi, lo;
+            packed_sum_parts(node->value.array.packed + start, len, &hi, &lo);
+            total += ((__int128)hi << 32) + lo - ((__int128)len << 63);
+        }
+        cell_set_i128(out, total);
+        return;
+    }
+    mpz_t acc;
+    mpz_init(acc);
+    long int small = 0, sum;
+    for (unsigned long i = 0; i < n; i++) {
+        const Cell *c = &node->value.array.data[i];
+        if (c->tag == CELL_BIG) {
+            mpz_add(acc, acc, c->z);
+        } else if (__builtin_add_overflow(small, c->small, &sum)) {
+            mpz_add_long(acc, small);
+            small = c->small;
+        } else {
+            small = sum;
+        }
+    }
+    mpz_add_long(acc, small);
+    cell_set_mpz(out, acc);
+    mpz_clear(acc);
+}
+
+int memory_array_max(const MemoryNode *node, Cell *out) {
+    unsigned long n = node->value.array.size;
+    if (n == 0) return 0;
+    if (node->value.array.packed) {
+        cell_set_si(out, packed_max(node->value.array.packed, n));
+        return 1;
+    }
+    const Cell *m = &node->value.array.data[0];
+    for (unsigned long i = 1; i < n; i++) {
+        if (cell_cmp(&node->value.array.data[i], m) > 0) m = &node->value.array.data[i];
+    }
+    cell_set(out, m);
+    return 1;
+}
+
+unsigned long memory_array_count(const MemoryNode *node, const Cell *v) {
+    unsigned long n = node->value.array.size, count = 0;
+    if (node->value.array.packed) {
+        return v->tag == CELL_SMALL ? packed_count(node->value.array.packed, n, v->small) : 0;
+    }
+    for (unsigned long i = 0; i < n; i++) count += cell_cmp(&node->value.array.data[i], v) == 0;
+    return count;
+}
+
+int memory_array_move(MemoryNode *dst, const MemoryNode *src) {
+    unsigned long n = src->value.array.size < dst->value.array.size ? src->value.array.size : dst->value.array.size;
+    if (dst == src || n == 0) return 1;
+    if (src->value.array.packed) {
+        if (dst->value.array.packed) {
+            memmove(dst->value.array.packed, src->value.array.packed, n * sizeof(long int));
+        } else {
+            for (unsigned long i = 0; i < n; i++) cell_set_si(&dst->value.array.data[i], src->value.array.packed[i]);
+        }
+        return 1;
+    }
+    if (dst->value.array.packed) {
+        for (unsigned long i = 0; i < n; i++) {
+            if (src->value.array.data[i].tag == CELL_BIG) {
+                if (!memory_array_promote(dst)) return 0;
+                break;
+            }
+        }
+    }
+    for (unsigned long i = 0; i < n; i++) memory_array_store(dst, i, &src->value.array.data[i]);
+    return 1;
+}
+
+void memory_array_dot(const MemoryNode *x, const MemoryNode *y, Cell *out) {
+    unsigned long n = x->value.array.size < y->value.array.size ? x->value.array.size : y->value.array.size;
+    unsigned long i = 0;
+    __int128 total = 0;
+    if (x->value.array.packed && y->value.array.packed) {
+        // Produits exacts sur 128 bits ; GMP seulement si la somme elle-même déborde
+        const long int *p = x->value.array.packed, *q = y->value.array.packed;
+        for (; i < n; i++) {
+            if (__builtin_add_overflow(total, (__int128)p[i] * q[i], &total)) break;
+        }
+        if (i == n) {
+            cell_set_i128(out, total);
+            return;
+        }
+        total = 0;
+        i = 0;
+    }
+    mpz_t acc, tx, ty;
+    mpz_init(acc);
+    mpz_init(tx);
+    mpz_init(ty);
+    for (; i < n; i++) {
+        if (x->value.array.packed) mpz_set_si(tx, x->value.array.packed[i]);
+        else cell_get_mpz(tx, &x->value.array.data[i]);
+        if (y->value.array.packed) mpz_set_si(ty, y->value.array.packed[i]);
+        else cell_get_mpz(ty, &y->value.array.data[i]);
+        mpz_addmul(acc, tx, ty);
+    }
+    cell_set_mpz(out, acc);
+    mpz_clear(acc);
+    mpz_clear(tx);
+    mpz_clear(ty);
+}
+
+// Libération en bloc : un seul parcours, sans recherche ni mise à jour des index.
+// Avec une arène, nœuds, noms et chaînes partent avec elle : seules les valeurs GMP sont rendues ici.
+void memory_destroy(MemoryList *list) {
+    Arena *arena = list->arena;
     MemoryNode *node = list->head;
-    while (node && strcmp(node->name, name) != 0) node = node->next;
+    while (node) {
+        MemoryNode *next = node->next;
+        if (arena) memory_node_clear_values(node);
+        else memory_node_clear(list, node);
+        node = next;
+    }
+    free(list->slots);
+    free(list->buckets);
+    memory_init(list);
+    list->arena = arena;
+}
+
+void print_variable(MemoryList *list, const char *name) {
+    MemoryNode *node = memory_find(list, name);
 
     if (!node) {
         printf("Variable '%s' non trouvée\n", name);
         return;
     }
     if (node->type == TYPE_VAR) {
-        char *num_str = mpz_get_str(NULL, 10, node->value.number);
+        char *num_str = cell_get_str(&node->value.number);
         printf("VAR '%s' = %s\n", name, num_str);
         free(num_str);
     } else {
@@ -152,8 +693,7 @@ void print_variable(MemoryList *list, const char *name) {
 }
 
 void print_string(MemoryList *list, const char *name) {
-    MemoryNode *node = list->head;
-    while (node && strcmp(node->name, name) != 0) node = node->next;
+    MemoryNode *node = memory_find(list, name);
 
     if (!node) {
         printf("String '%s' non trouvée\n", name);
@@ -167,8 +707,7 @@ void print_string(MemoryList *list, const char *name) {
 }
 
 void print_array(MemoryList *list, const char *name) {
-    MemoryNode *node = list->head;
-    while (node && strcmp(node->name, name) != 0) node = node->next;
+    MemoryNode *node = memory_find(list, name);
 
     if (!node) {
         printf("Array '%s' non trouvé\n", name);
@@ -177,7 +716,11 @@ void print_array(MemoryList *list, const char *name) {
     if (node->type == TYPE_ARRAY) {
         printf("ARRAY '%s' (taille = %lu): [", name, node->value.array.size);
         for (unsigned long i = 0; i < node->value.array.size; i++) {
-            char *num_str = mpz_get_str(NULL, 10, node->value.array.data[i]);
+            Cell value;
+            cell_init(&value);
+            memory_array_fetch(node, i, &value);
+            char *num_str = cell_get_str(&value);
+            cell_clear(&value);
             printf("%s", num_str);
             free(num_str);
             if (i < node->value.array.size - 1) printf(", ");
@@ -14,25 +14,223 @@
 #define TYPE_MASK   0xF0000000UL  // 4 bits supérieurs pour le type
 #define INDEX_MASK  0x0FFFFFFFUL  // 28 bits inférieurs pour l'index
 
+// L'index est lui-même un handle : numéro de slot (20 bits) + génération (8 bits).
+// La génération change à chaque libération du slot, ce qui invalide les anciens handles.
+#define SLOT_MASK   0x000FFFFFUL  // Slot dans la table de MemoryList
+#define GEN_SHIFT   20
+#define GEN_MASK    0xFFUL        // Génération, après décalage de GEN_SHIFT
+#define SLOT_NONE   (~0UL)        // Fin de la liste des slots libres
+
+// Cellule Forth : entier natif tant que la valeur tient dans un long,
+// promue en mpz_t au premier débordement. Le mpz_t n'est initialisé qu'à
+// la première promotion puis conservé pour réutiliser ses limbs.
+#define CELL_SMALL 0
+#define CELL_BIG   1
+
+typedef struct {
+    int tag;                 // CELL_SMALL ou CELL_BIG
+    int z_ready;             // z a été initialisé par mpz_init
+    long int small;          // Valeur si tag == CELL_SMALL
+    mpz_t z;                 // Valeur si tag == CELL_BIG
+} Cell;
+
+static inline void cell_init(Cell *c) {
+    c->tag = CELL_SMALL;
+    c->z_ready = 0;
+    c->small = 0;
+}
+
+static inline void cell_clear(Cell *c) {
+    if (c->z_ready) mpz_clear(c->z);
+    c->z_ready = 0;
+    c->tag = CELL_SMALL;
+    c->small = 0;
+}
+
+static inline void cell_ensure_z(Cell *c) {
+    if (!c->z_ready) {
+        mpz_init(c->z);
+        c->z_ready = 1;
+    }
+}
+
+static inline void cell_set_si(Cell *c, long int v) {
+    c->tag = CELL_SMALL;
+    c->small = v;
+}
+
+// Repasse en représentation native si la valeur GMP tient dans un long
+static inline void cell_normalize(Cell *c) {
+    if (c->tag == CELL_BIG && mpz_fits_slong_p(c->z)) {
+        c->small = mpz_get_si(c->z);
+        c->tag = CELL_SMALL;
+    }
+}
+
+static inline void cell_set_mpz(Cell *c, mpz_srcptr v) {
+    if (mpz_fits_slong_p(v)) {
+        cell_set_si(c, mpz_get_si(v));
+    } else {
+        cell_ensure_z(c);
+        mpz_set(c->z, v);
+        c->tag = CELL_BIG;
+    }
+}
+
+static inline void cell_set(Cell *dst, const Cell *src) {
+    if (dst == src) return;
+    if (src->tag == CELL_SMALL) {
+        cell_set_si(dst, src->small);
+    } else {
+        cell_ensure_z(dst);
+        mpz_set(dst->z, src->z);
+        dst->tag = CELL_BIG;
+    }
+}
+
+// Échange en O(1) : seuls les en-têtes bougent, les limbs GMP restent en place (comme mpz_swap)
+static inline void cell_swap(Cell *a, Cell *b) {
+    Cell tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// Valeur GMP de la cellule : z si promue, sinon tmp chargé avec la valeur native
+static inline mpz_srcptr cell_mpz(const Cell *c, mpz_ptr tmp) {
+    if (c->tag == CELL_BIG) return c->z;
+    mpz_set_si(tmp, c->small);
+    return tmp;
+}
+
+static inline void cell_get_mpz(mpz_ptr out, const Cell *c) {
+    if (c->tag == CELL_BIG) mpz_set(out, c->z);
+    else mpz_set_si(out, c->small);
+}
+
+// Mêmes conventions que mpz_get_si / mpz_get_ui
+static inline long int cell_get_si(const Cell *c) {
+    return c->tag == CELL_SMALL ? c->small : mpz_get_si(c->z);
+}
+
+static inline unsigned long cell_get_ui(const Cell *c) {
+    if (c->tag == CELL_BIG) return mpz_get_ui(c->z);
+    return c->small < 0 ? -(unsigned long)c->small : (unsigned long)c->small;
+}
+
+static inline int cell_sgn(const Cell *c) {
+    if (c->tag == CELL_BIG) return mpz_sgn(c->z);
+    return (c->small > 0) - (c->small < 0);
+}
+
+static inline int cell_cmp(const Cell *a, const Cell *b) {
+    if (a->tag == CELL_SMALL && b->tag == CELL_SMALL)
+        return (a->small > b->small) - (a->small < b->small);
+    if (a->tag == CELL_SMALL) return -mpz_cmp_si(b->z, a->small);
+    if (b->tag == CELL_SMALL) return mpz_cmp_si(a->z, b->small);
+    return mpz_cmp(a->z, b->z);
+}
+
+char *cell_get_str(const Cell *c); // Chaîne décimale allouée (à libérer avec free)
+char *mpz_get_str_alloc(int base, mpz_srcptr z); // Comme mpz_get_str(NULL, ...) mais via malloc, à libérer avec free
+
+// Arène par utilisateur : petits blocs pris dans des pages par classes de taille
+// (16 à 512 octets, listes libres par classe), gros blocs chaînés à part.
+// Tout est rendu d'un coup par arena_destroy. Un pointeur d'arène NULL revient à malloc/free.
+#define ARENA_PAGE_SIZE   16384
+#define ARENA_MIN_SHIFT   4      // Plus petite classe : 16 octets
+#define ARENA_CLASS_COUNT 6      // 16, 32, 64, 128, 256, 512
+#define ARENA_MAX_SMALL   (1UL << (ARENA_MIN_SHIFT + ARENA_CLASS_COUNT - 1))
+
+typedef struct ArenaPage {
+    struct ArenaPage *next;
+    size_t used;             // Octets déjà distribués dans la page
+    size_t pad;              // Garde les données alignées sur 16 octets
+} ArenaPage;
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *prev;
+    struct ArenaBlock *next;
+    size_t size;             // Taille demandée
+    size_t pad;
+} ArenaBlock;
+
+typedef struct {
+    ArenaPage *pages;        // Page courante en tête
+    void *free_list[ARENA_CLASS_COUNT];
+    ArenaBlock *large;       // Blocs de plus de ARENA_MAX_SMALL octets
+    size_t bytes_used;       // Octets occupés (arrondis à la classe pour les petits blocs)
+    size_t bytes_reserved;   // Octets pris au système : pages et gros blocs
+} Arena;
+
+void arena_init(Arena *arena);
+void arena_destroy(Arena *arena);
+void *arena_alloc(Arena *arena, size_t size);
+void arena_free(Arena *arena, void *ptr, size_t size); // size : celle passée à arena_alloc
+char *arena_strdup(Arena *arena, const char *str);
+char *arena_strndup(Arena *arena, const char *str, size_t len);
+void arena_free_str(Arena *arena, char *str);
+
+// Chaîne immuable partagée par compteur de références. L'en-tête précède les octets
+// dans le même bloc (une seule classe de l'arène pour les petites chaînes) et le pointeur
+// manipulé est celui des octets : il reste une chaîne C terminée par '\0'.
+typedef struct {
+    unsigned int refs;       // Propriétaires : pile de chaînes, nœuds STRING, mots compilés
+    unsigned int len;        // Longueur sans le '\0'
+} FStrHeader;
+
+#define FSTR_HDR(s) ((FStrHeader *)(s) - 1)
+
+char *fstr_new(Arena *arena, const char *str, size_t len); // Une référence, NULL si l'allocation échoue
+void fstr_release(Arena *arena, char *s);                  // Libère à la dernière référence
+
+static inline char *fstr_ref(char *s) {
+    if (s) FSTR_HDR(s)->refs++;
+    return s;
+}
+
+static inline size_t fstr_len(const char *s) {
+    return s ? ((const FStrHeader *)s - 1)->len : 0;
+}
+
 // Structure pour un nœud de mémoire
 typedef struct MemoryNode {
     char *name;              // Nom du nœud
     unsigned long type;      // Type (TYPE_VAR, TYPE_STRING, TYPE_ARRAY)
     union {
-        mpz_t number;        // Pour TYPE_VAR
-        char *string;        // Pour TYPE_STRING
+        Cell number;         // Pour TYPE_VAR
+        char *string;        // Pour TYPE_STRING : chaîne partagée (fstr_*)
         struct {
-            mpz_t *data;     // Données pour TYPE_ARRAY
+            Cell *data;      // Données pour TYPE_ARRAY, NULL tant que le tableau est compact
+            long int *packed; // Tableau compact : entiers natifs contigus, jusqu'au premier débordement
             unsigned long size; // Taille du tableau
+            unsigned long capacity; // Éléments alloués (croissance géométrique)
         } array;
     } value;
+    unsigned long slot;      // Slot occupé dans la table de handles
+    unsigned long hash;      // Hachage du nom, pour l'index par nom
     struct MemoryNode *next; // Pointeur vers le nœud suivant
+    struct MemoryNode *prev; // Nœud précédent (retrait en O(1))
+    struct MemoryNode *name_next; // Nœud suivant dans le même seau de l'index par nom
 } MemoryNode;
 
+// Entrée de la table de handles
+typedef struct {
+    MemoryNode *node;        // NULL si le slot est libre
+    unsigned long gen;       // Génération courante du slot
+    unsigned long next_free; // Slot libre suivant (si node == NULL)
+} MemorySlot;
+
 // Structure pour la liste de mémoire
 typedef struct {
     MemoryNode *head;        // Tête de la liste
     unsigned long count;     // Nombre total de nœuds
+    MemorySlot *slots;       // Table de handles : accès direct par numéro de slot
+    unsigned long capacity;  // Slots alloués
+    unsigned long used;      // Slots déjà distribués (libres ou non)
+    unsigned long free_head; // Premier slot libre à réutiliser, SLOT_NONE sinon
+    MemoryNode **buckets;    // Index par nom : seaux chaînés, le plus récent en tête
+    unsigned long bucket_count; // Puissance de 2, 0 tant que rien n'a été créé
+    Arena *arena;            // Nœuds, noms et chaînes ; NULL pour malloc/free
 } MemoryList;
 
 // Prototypes des fonctions
@@ -40,11 +238,44 @@ MemoryNode *memory_get_by_name(MemoryList *list, const char *name); // Nouvelle
 void memory_init(MemoryList *list);
 unsigned long memory_create(MemoryList *list, const char *name, unsigned long type);
 MemoryNode *memory_get(MemoryList *list, unsigned long encoded_index);
-void memory_store(MemoryList *list, unsigned long encoded_index, void *data);
-void memory_fetch(MemoryList *list, unsigned long encoded_index, void *result);
+void memory_store(MemoryList *list, unsigned long encoded_index, void *data);   // TYPE_VAR : Cell *, TYPE_STRING : char *
+void memory_fetch(MemoryList *list, unsigned long encoded_index, void *result); // TYPE_VAR : Cell *, TYPE_STRING : char **
 void memory_free(MemoryList *list, const char *name);
+void memory_store_string(MemoryList *list, unsigned long encoded_index, char *str); // Prend la référence de str
+char *memory_fetch_string(MemoryList *list, unsigned long encoded_index);           // Référence empruntée, ou NULL
+int memory_array_resize(MemoryNode *node, unsigned long new_size); // 0 si l'allocation échoue
+int memory_array_promote(MemoryNode *node); // Passe le tableau en cellules (data), 0 si l'allocation échoue
+
+// Opérations sur tout un tableau (vectorisées quand il est compact)
+int memory_array_fill(MemoryNode *node, const Cell *v); // 0 si l'allocation échoue
+void memory_array_sum(const MemoryNode *node, Cell *out);
+int memory_array_max(const MemoryNode *node, Cell *out); // 0 si le tableau est vide
+unsigned long memory_array_count(const MemoryNode *node, const Cell *v); // Éléments égaux à v
+int memory_array_move(MemoryNode *dst, const MemoryNode *src); // min(tailles) éléments, 0 si l'allocation échoue
+void memory_array_dot(const MemoryNode *x, const MemoryNode *y, Cell *out); // Sur min(tailles) éléments
+void memory_free_handle(MemoryList *list, unsigned long encoded_index); // Libère exactement ce nœud
+void memory_destroy(MemoryList *list); // Libère tous les nœuds, la table de handles et l'index
 unsigned long memory_get_type(unsigned long encoded_index);
 
+// Accès aux éléments d'un TYPE_ARRAY, l'index étant déjà vérifié (< size)
+static inline void memory_array_fetch(const MemoryNode *node, unsigned long i, Cell *out) {
+    if (node->value.array.packed) cell_set_si(out, node->value.array.packed[i]);
+    else cell_set(out, &node->value.array.data[i]);
+}
+
+// 0 si la valeur déborde d'un tableau compact et que la promotion échoue
+static inline int memory_array_store(MemoryNode *node, unsigned long i, const Cell *v) {
+    if (node->value.array.packed) {
+        if (v->tag == CELL_SMALL) {
+            node->value.array.packed[i] = v->small;
+            return 1;
+        }
+        if (!memory_array_promote(node)) return 0;
+    }
+    cell_set(&node->value.array.data[i], v);
+    return 1;
+}
+
 // Fonctions d'affichage
 void print_variable(MemoryList *list, const char *name);
 void print_string(MemoryList *list, const char *name);